@@ -0,0 +1,111 @@
+#ifndef COMPRESSION_CPP_BENCH_CORPUS_H
+#define COMPRESSION_CPP_BENCH_CORPUS_H
+
+#include <string>
+#include <vector>
+#include <random>
+#include <fstream>
+#include <iterator>
+#include <cstdlib>
+#include <benchmark/benchmark.h>
+
+// Inputs of the benchmarks, each about corpus::size bytes: synthetic data generated with a fixed seed and real
+// data from the sources of this repository (or the file in COMPRESSION_BENCH_FILE)
+namespace corpus {
+    constexpr static size_t size = size_t{1} << 20; // 1 MiB
+
+    enum Kind : int64_t {
+        Text, // words with Zipf-like frequencies, like natural language
+        Random, // uniformly distributed bytes, incompressible
+        Source, // real data
+        NumKinds,
+    };
+
+    namespace internal {
+        [[maybe_unused]]
+        static std::string text() {
+            std::mt19937 gen(42); // NOLINT
+            std::vector<std::string> words;
+            std::uniform_int_distribution<int> letter('a', 'z');
+            std::uniform_int_distribution<size_t> wordLength(1, 10);
+            for (size_t i = 0; i < 5000; ++i) {
+                std::string word(wordLength(gen), ' ');
+                for (char& c : word) c = static_cast<char>(letter(gen));
+                words.push_back(word);
+            }
+            // the probability of the i-th word is proportional to 1/(i+1)
+            std::vector<double> weights;
+            for (size_t i = 0; i < words.size(); ++i) weights.push_back(1.0 / static_cast<double>(i + 1));
+            std::discrete_distribution<size_t> pick(weights.begin(), weights.end());
+
+            std::string out;
+            while (out.size() < size) {
+                out += words[pick(gen)];
+                out += gen() % 12 == 0 ? ".\n" : " ";
+            }
+            out.resize(size);
+            return out;
+        }
+
+        [[maybe_unused]]
+        static std::string random() {
+            std::mt19937 gen(42); // NOLINT
+            std::string out(size, '\0');
+            for (char& c : out) c = static_cast<char>(gen());
+            return out;
+        }
+
+        [[maybe_unused]]
+        static std::string source() {
+            std::vector<std::string> files;
+            if (const char* file = std::getenv("COMPRESSION_BENCH_FILE")) {
+                files.emplace_back(file);
+            } else {
+                for (const char* name : {"include/Huffman.h", "include/LZW.h", "include/BlockStream.h",
+                                         "include/MoveToFront.h", "include/CircularSuffix.h", "src/compress.cpp",
+                                         "include/external/argagg.h", "README.md"}) {
+                    files.push_back(std::string(COMPRESSION_SOURCE_DIR) + "/" + name);
+                }
+            }
+            std::string all;
+            for (const std::string& name : files) {
+                std::ifstream ifs(name, std::ios::binary);
+                all.append(std::istreambuf_iterator<char>(ifs), {});
+            }
+            if (all.empty()) return text();
+            // repeat small files, so that all inputs have about the same size
+            std::string out;
+            while (out.size() < size) out += all;
+            out.resize(std::min(out.size(), std::max(size, all.size())));
+            return out;
+        }
+    }
+
+    // input of the given kind, generated once
+    [[maybe_unused]]
+    static const std::string& get(const int64_t kind) {
+        static const std::string inputs[NumKinds] = {internal::text(), internal::random(), internal::source()};
+        return inputs[kind];
+    }
+
+    [[maybe_unused]]
+    static const char* name(const int64_t kind) {
+        static const char* names[NumKinds] = {"text", "random", "source"};
+        return names[kind];
+    }
+
+    // run a benchmark once for each kind of input, with the kind as first argument
+    [[maybe_unused]]
+    static void allKinds(benchmark::internal::Benchmark* b) {
+        for (int64_t kind = 0; kind < NumKinds; ++kind) b->Arg(kind);
+    }
+
+    // report the throughput of state for processing the input once per iteration
+    [[maybe_unused]]
+    static void setThroughput(benchmark::State& state, const size_t bytesPerIteration) {
+        state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * bytesPerIteration));
+        state.SetLabel(name(state.range(0)));
+    }
+}
+
+#endif //COMPRESSION_CPP_BENCH_CORPUS_H
@@ -0,0 +1,52 @@
+#include <benchmark/benchmark.h>
+#include <sstream>
+#include <vector>
+#include <random>
+#include "BitStreamOut.h"
+#include "BitStreamIn.h"
+#include "Corpus.h"
+
+// widths of the values, between 1 and 20 bits like Huffman and LZW codes
+static std::vector<uint8_t> widths(const size_t n) {
+    std::mt19937 gen(42); // NOLINT
+    std::uniform_int_distribution<int> width(1, 20);
+    std::vector<uint8_t> out(n);
+    for (uint8_t& w : out) w = static_cast<uint8_t>(width(gen));
+    return out;
+}
+
+static void BM_BitStreamOut_writeBits(benchmark::State& state) {
+    const std::string& input = corpus::get(state.range(0));
+    const std::vector<uint8_t> numBits = widths(input.size() / 4);
+    const auto* values = reinterpret_cast<const uint32_t*>(input.data());
+    size_t totalBits = 0;
+    for (const uint8_t n : numBits) totalBits += n;
+
+    for (auto _ : state) {
+        std::ostringstream oss(std::ios::binary);
+        BitStreamOut bso(oss);
+        for (size_t i = 0; i < numBits.size(); ++i) bso.writeBits(values[i], numBits[i]);
+        bso.flush();
+        benchmark::DoNotOptimize(oss.tellp());
+    }
+    corpus::setThroughput(state, totalBits / 8);
+}
+BENCHMARK(BM_BitStreamOut_writeBits)->Apply(corpus::allKinds);
+
+static void BM_BitStreamIn_readBits(benchmark::State& state) {
+    const std::string& input = corpus::get(state.range(0));
+    const std::vector<uint8_t> numBits = widths(input.size() / 4);
+    size_t totalBits = 0;
+    for (const uint8_t n : numBits) totalBits += n;
+    const std::string data = input.substr(0, (totalBits + 7) / 8);
+
+    for (auto _ : state) {
+        std::istringstream iss(data, std::ios::binary);
+        BitStreamIn bsi(iss);
+        uint32_t sum = 0;
+        for (const uint8_t n : numBits) sum += bsi.readBits(n);
+        benchmark::DoNotOptimize(sum);
+    }
+    corpus::setThroughput(state, data.size());
+}
+BENCHMARK(BM_BitStreamIn_readBits)->Apply(corpus::allKinds);
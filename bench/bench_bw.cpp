@@ -0,0 +1,22 @@
+#include <benchmark/benchmark.h>
+#include "BurrowsWheeler.h"
+#include "Corpus.h"
+
+static void BM_BurrowsWheeler_encode(benchmark::State& state) {
+    const std::string& input = corpus::get(state.range(0));
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(bw::encode(input));
+    }
+    corpus::setThroughput(state, input.size());
+}
+BENCHMARK(BM_BurrowsWheeler_encode)->Apply(corpus::allKinds)->Unit(benchmark::kMillisecond);
+
+static void BM_BurrowsWheeler_decode(benchmark::State& state) {
+    const std::string& input = corpus::get(state.range(0));
+    const std::string encoded = bw::encode(input);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(bw::decode(encoded));
+    }
+    corpus::setThroughput(state, input.size());
+}
+BENCHMARK(BM_BurrowsWheeler_decode)->Apply(corpus::allKinds)->Unit(benchmark::kMillisecond);
@@ -0,0 +1,18 @@
+#include <benchmark/benchmark.h>
+#include "CRC32C.h"
+#include "Corpus.h"
+
+template<crc32c::internal::Kernel kernel>
+static void BM_CRC32C(benchmark::State& state) {
+    const std::string& input = corpus::get(state.range(0));
+    const auto* data = reinterpret_cast<const uint8_t*>(input.data());
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(kernel(~0u, data, input.size()));
+    }
+    corpus::setThroughput(state, input.size());
+}
+BENCHMARK_TEMPLATE(BM_CRC32C, crc32c::internal::extendBytewise)->Name("BM_CRC32C_bytewise")->Apply(corpus::allKinds);
+BENCHMARK_TEMPLATE(BM_CRC32C, crc32c::internal::extendSlicing8)->Name("BM_CRC32C_slicing8")->Apply(corpus::allKinds);
+#ifdef CRC32C_X86_KERNEL
+BENCHMARK_TEMPLATE(BM_CRC32C, crc32c::internal::extendSSE42)->Name("BM_CRC32C_SSE42")->Apply(corpus::allKinds);
+#endif
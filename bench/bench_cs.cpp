@@ -0,0 +1,13 @@
+#include <benchmark/benchmark.h>
+#include "CircularSuffix.h"
+#include "Corpus.h"
+
+static void BM_CircularSuffix_sort(benchmark::State& state) {
+    const std::string& input = corpus::get(state.range(0));
+    const auto sv = std::basic_string_view<uint8_t>(reinterpret_cast<const uint8_t*>(input.data()), input.size());
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(circular_suffix::sort<uint8_t>(sv));
+    }
+    corpus::setThroughput(state, input.size());
+}
+BENCHMARK(BM_CircularSuffix_sort)->Apply(corpus::allKinds)->Unit(benchmark::kMillisecond);
@@ -0,0 +1,61 @@
+#include <benchmark/benchmark.h>
+#include <sstream>
+#include "Huffman.h"
+#include "Corpus.h"
+
+static void BM_Huffman_buildTrie(benchmark::State& state) {
+    const std::string& input = corpus::get(state.range(0));
+    const auto freq = huffman::internal::histogram(input);
+    for (auto _ : state) {
+        huffman::Trie trie = huffman::internal::buildTrie(freq);
+        benchmark::DoNotOptimize(trie->freq());
+    }
+    // relative to the input the trie is built for, so that it compares with the other stages of a block
+    corpus::setThroughput(state, input.size());
+}
+BENCHMARK(BM_Huffman_buildTrie)->Apply(corpus::allKinds);
+
+static void BM_Huffman_histogram(benchmark::State& state) {
+    const std::string& input = corpus::get(state.range(0));
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(huffman::internal::histogram(input));
+    }
+    corpus::setThroughput(state, input.size());
+}
+BENCHMARK(BM_Huffman_histogram)->Apply(corpus::allKinds);
+
+static void BM_Huffman_encode(benchmark::State& state) {
+    const std::string& input = corpus::get(state.range(0));
+    const huffman::Trie trie = huffman::buildTrie(input);
+    const huffman::TrieTable table = huffman::internal::trie2table(*trie);
+    for (auto _ : state) {
+        std::ostringstream oss(std::ios::binary);
+        {
+            BitStreamOut bso(oss);
+            huffman::internal::encode(input, bso, table);
+            bso.flush();
+        }
+        benchmark::DoNotOptimize(oss.tellp());
+    }
+    corpus::setThroughput(state, input.size());
+}
+BENCHMARK(BM_Huffman_encode)->Apply(corpus::allKinds);
+
+static void BM_Huffman_compress(benchmark::State& state) {
+    const std::string& input = corpus::get(state.range(0));
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(huffman::compress(input, huffman::Format::Canonical));
+    }
+    corpus::setThroughput(state, input.size());
+}
+BENCHMARK(BM_Huffman_compress)->Apply(corpus::allKinds);
+
+static void BM_Huffman_expand(benchmark::State& state) {
+    const std::string& input = corpus::get(state.range(0));
+    const std::string compressed = huffman::compress(input, huffman::Format::Canonical);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(huffman::expand(compressed, huffman::Format::Canonical));
+    }
+    corpus::setThroughput(state, input.size());
+}
+BENCHMARK(BM_Huffman_expand)->Apply(corpus::allKinds);
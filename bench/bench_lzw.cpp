@@ -0,0 +1,24 @@
+#include <benchmark/benchmark.h>
+#include "LZW.h"
+#include "Corpus.h"
+
+template<typename Dictionary>
+static void BM_LZW_compress(benchmark::State& state) {
+    const std::string& input = corpus::get(state.range(0));
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(lzw::compress<Dictionary>(input));
+    }
+    corpus::setThroughput(state, input.size());
+}
+BENCHMARK_TEMPLATE(BM_LZW_compress, lzw::HashDictionary)->Apply(corpus::allKinds);
+BENCHMARK_TEMPLATE(BM_LZW_compress, lzw::TrieDictionary)->Apply(corpus::allKinds);
+
+static void BM_LZW_expand(benchmark::State& state) {
+    const std::string& input = corpus::get(state.range(0));
+    const std::string compressed = lzw::compress(input);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(lzw::expand(compressed));
+    }
+    corpus::setThroughput(state, input.size());
+}
+BENCHMARK(BM_LZW_expand)->Apply(corpus::allKinds);
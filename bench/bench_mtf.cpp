@@ -0,0 +1,56 @@
+#include <benchmark/benchmark.h>
+#include "MoveToFront.h"
+#include "BurrowsWheeler.h"
+#include "Corpus.h"
+
+// the move-to-front transform is applied to the output of the Burrows-Wheeler transform in BWMH, which is benchmarked
+// in addition to the raw inputs with the kinds after corpus::NumKinds
+static const std::string& input(const int64_t arg) {
+    if (arg < corpus::NumKinds) return corpus::get(arg);
+    static const std::string transformed[corpus::NumKinds] = {bw::encode(corpus::get(0)),
+                                                              bw::encode(corpus::get(1)),
+                                                              bw::encode(corpus::get(2))};
+    return transformed[arg - corpus::NumKinds];
+}
+
+static void allInputs(benchmark::internal::Benchmark* b) {
+    for (int64_t arg = 0; arg < 2 * corpus::NumKinds; ++arg) b->Arg(arg);
+}
+
+static void setThroughput(benchmark::State& state, const size_t bytesPerIteration) {
+    const int64_t arg = state.range(0);
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * bytesPerIteration));
+    state.SetLabel(std::string(arg < corpus::NumKinds ? "" : "bw ") + corpus::name(arg % corpus::NumKinds));
+}
+
+template<mtf::internal::Kernel kernel, bool decode, bool avx2 = false>
+static void BM_MoveToFront(benchmark::State& state) {
+    if (avx2 && !mtf::internal::supportsAVX2()) {
+        state.SkipWithError("AVX2 is not supported");
+        return;
+    }
+    std::string data = input(state.range(0));
+    if (decode) mtf::encode(data);
+    std::string buf = data;
+    for (auto _ : state) {
+        state.PauseTiming();
+        buf = data;
+        state.ResumeTiming();
+        mtf::internal::State mtfState;
+        kernel(mtfState, buf.data(), buf.size());
+        benchmark::DoNotOptimize(buf.data());
+    }
+    setThroughput(state, data.size());
+}
+BENCHMARK_TEMPLATE(BM_MoveToFront, mtf::internal::encode, false)->Name("BM_MoveToFront_encode")->Apply(allInputs);
+BENCHMARK_TEMPLATE(BM_MoveToFront, mtf::internal::decode, true)->Name("BM_MoveToFront_decode")->Apply(allInputs);
+#ifdef MTF_X86_KERNELS
+BENCHMARK_TEMPLATE(BM_MoveToFront, mtf::internal::encodeSSE2, false)->Name("BM_MoveToFront_encodeSSE2")
+        ->Apply(allInputs);
+BENCHMARK_TEMPLATE(BM_MoveToFront, mtf::internal::decodeSSE2, true)->Name("BM_MoveToFront_decodeSSE2")
+        ->Apply(allInputs);
+BENCHMARK_TEMPLATE(BM_MoveToFront, mtf::internal::encodeAVX2, false, true)->Name("BM_MoveToFront_encodeAVX2")
+        ->Apply(allInputs);
+BENCHMARK_TEMPLATE(BM_MoveToFront, mtf::internal::decodeAVX2, true, true)->Name("BM_MoveToFront_decodeAVX2")
+        ->Apply(allInputs);
+#endif
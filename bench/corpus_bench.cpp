@@ -0,0 +1,593 @@
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <map>
+#include <random>
+#include <chrono>
+#include <functional>
+#include <algorithm>
+#include <stdexcept>
+#include <cmath>
+#include <cstdio>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include "external/argagg.h"
+
+// End-to-end benchmark of the compress executable on a corpus in the style of the Canterbury and Silesia corpora.
+// The files are generated with fixed seeds, so the results of different builds can be compared: each file is
+// compressed and extracted with each codec in a child process, whose wall time and peak resident set size (from
+// wait4) are reported as a table and optionally as JSON, which can be given as baseline to a later run.
+
+// a file of the corpus, generated into a string of about the given size
+struct CorpusFile {
+    std::string name;
+    std::string description;
+    std::function<std::string(size_t)> generate;
+};
+
+struct Codec {
+    std::string name;
+    std::string flag; // option of compress, empty for the default codec
+    std::string extension;
+};
+
+struct Result {
+    std::string file;
+    std::string codec;
+    uint64_t size = 0;
+    uint64_t compressedSize = 0;
+    double compressSeconds = 0;
+    double expandSeconds = 0;
+    long compressRssKiB = 0;
+    long expandRssKiB = 0;
+
+    [[nodiscard]]
+    double ratio() const {
+        return compressedSize > 0 ? static_cast<double>(size) / static_cast<double>(compressedSize) : 0;
+    }
+
+    [[nodiscard]]
+    double compressMBps() const {
+        return compressSeconds > 0 ? static_cast<double>(size) / 1e6 / compressSeconds : 0;
+    }
+
+    [[nodiscard]]
+    double expandMBps() const {
+        return expandSeconds > 0 ? static_cast<double>(size) / 1e6 / expandSeconds : 0;
+    }
+};
+
+namespace generate {
+    // picks words with Zipf-like frequencies: the i-th word is 1/(i+1) times as likely as the first one
+    class Vocabulary {
+    public:
+        Vocabulary(std::vector<std::string> words, std::mt19937& gen) : words{std::move(words)}, gen{gen} {
+            std::vector<double> weights;
+            for (size_t i = 0; i < this->words.size(); ++i) weights.push_back(1.0 / static_cast<double>(i + 1));
+            pick = std::discrete_distribution<size_t>(weights.begin(), weights.end());
+        }
+
+        const std::string& operator()() {
+            return words[pick(gen)];
+        }
+
+    private:
+        std::vector<std::string> words;
+        std::mt19937& gen;
+        std::discrete_distribution<size_t> pick;
+    };
+
+    // random lower case words with 1 to maxLength letters
+    static std::vector<std::string> randomWords(std::mt19937& gen, const size_t n, const size_t maxLength) {
+        std::uniform_int_distribution<int> letter('a', 'z');
+        std::uniform_int_distribution<size_t> length(1, maxLength);
+        std::vector<std::string> words;
+        for (size_t i = 0; i < n; ++i) {
+            std::string word(length(gen), ' ');
+            for (char& c : word) c = static_cast<char>(letter(gen));
+            words.push_back(word);
+        }
+        return words;
+    }
+
+    // prose in lines of at most 72 characters, like alice29.txt
+    static std::string text(const size_t size) {
+        std::mt19937 gen(1); // NOLINT
+        std::vector<std::string> words = {"the", "and", "to", "a", "she", "it", "of", "said", "i", "alice", "in",
+                                          "you", "was", "that", "as", "her", "at", "on", "with", "all", "had"};
+        for (std::string& word : randomWords(gen, 3000, 9)) words.push_back(word);
+        Vocabulary vocabulary(words, gen);
+        std::string out;
+        size_t lineLength = 0;
+        bool capitalize = true;
+        while (out.size() < size) {
+            std::string word = vocabulary();
+            if (capitalize) word[0] = static_cast<char>(word[0] - 'a' + 'A');
+            capitalize = gen() % 10 == 0;
+            if (capitalize) word += gen() % 4 == 0 ? "!" : ".";
+            else if (gen() % 12 == 0) word += ",";
+            if (lineLength + word.size() + 1 > 72) {
+                out += gen() % 8 == 0 ? "\n\n" : "\n";
+                lineLength = 0;
+            } else if (lineLength > 0) {
+                out += ' ';
+                ++lineLength;
+            }
+            out += word;
+            lineLength += word.size();
+        }
+        out.resize(size);
+        return out;
+    }
+
+    // C-like functions with indentation and a small set of identifiers, like the sources in the Canterbury corpus
+    static std::string source(const size_t size) {
+        std::mt19937 gen(2); // NOLINT
+        Vocabulary identifiers(randomWords(gen, 400, 12), gen);
+        const std::vector<std::string> types = {"int", "size_t", "char*", "double", "uint32_t", "void"};
+        const auto type = [&]() { return types[gen() % types.size()]; };
+        std::string out;
+        while (out.size() < size) {
+            out += "static " + type() + " " + identifiers() + "(" + type() + " " + identifiers() + ", "
+                   + type() + " " + identifiers() + ") {\n";
+            const size_t numStatements = 2 + gen() % 10;
+            size_t indent = 1;
+            for (size_t i = 0; i < numStatements; ++i) {
+                const std::string spaces(4 * indent, ' ');
+                switch (gen() % 5) {
+                    case 0:
+                        out += spaces + "for (size_t i = 0; i < " + identifiers() + "; ++i) {\n";
+                        ++indent;
+                        break;
+                    case 1:
+                        out += spaces + "if (" + identifiers() + " == " + std::to_string(gen() % 100) + ") {\n";
+                        ++indent;
+                        break;
+                    case 2:
+                        if (indent > 1) {
+                            --indent;
+                            out += std::string(4 * indent, ' ') + "}\n";
+                            break;
+                        }
+                        [[fallthrough]];
+                    default:
+                        out += spaces + identifiers() + " = " + identifiers() + "(" + identifiers() + ", "
+                               + std::to_string(gen() % 1000) + ");\n";
+                }
+            }
+            while (indent > 1) {
+                --indent;
+                out += std::string(4 * indent, ' ') + "}\n";
+            }
+            out += "    return " + identifiers() + ";\n}\n\n";
+        }
+        out.resize(size);
+        return out;
+    }
+
+    // nested records with attributes, like the XML files in the Silesia corpus
+    static std::string markup(const size_t size) {
+        std::mt19937 gen(3); // NOLINT
+        Vocabulary words(randomWords(gen, 2000, 8), gen);
+        std::string out = "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n<records>\n";
+        for (size_t id = 0; out.size() < size; ++id) {
+            out += "  <record id=\"" + std::to_string(id) + "\" type=\"" + words() + "\">\n";
+            out += "    <name>" + words() + " " + words() + "</name>\n";
+            out += "    <value unit=\"" + words() + "\">" + std::to_string(gen() % 100000) + "</value>\n";
+            out += "    <description>";
+            for (size_t i = 0, n = 3 + gen() % 15; i < n; ++i) out += (i > 0 ? " " : "") + words();
+            out += "</description>\n  </record>\n";
+        }
+        out.resize(size);
+        return out;
+    }
+
+    // web server log with increasing time stamps
+    static std::string log(const size_t size) {
+        std::mt19937 gen(4); // NOLINT
+        Vocabulary paths(randomWords(gen, 300, 10), gen);
+        const std::vector<std::string> levels = {"INFO", "INFO", "INFO", "DEBUG", "WARN", "ERROR"};
+        std::string out;
+        uint64_t time = 1700000000;
+        while (out.size() < size) {
+            time += gen() % 3;
+            out += std::to_string(time) + " " + levels[gen() % levels.size()] + " 10.0." + std::to_string(gen() % 4)
+                   + "." + std::to_string(gen() % 256) + " GET /" + paths() + "/" + paths() + " "
+                   + (gen() % 10 == 0 ? "404" : "200") + " " + std::to_string(gen() % 50000) + "\n";
+        }
+        out.resize(size);
+        return out;
+    }
+
+    // nucleotides with repeated segments and mutations, like E.coli
+    static std::string dna(const size_t size) {
+        std::mt19937 gen(5); // NOLINT
+        const char bases[] = "acgt";
+        std::string out;
+        while (out.size() < size) {
+            if (out.size() > 1000 && gen() % 4 == 0) {
+                // copy of an earlier segment with a few point mutations
+                const size_t length = 20 + gen() % 200;
+                const size_t start = gen() % (out.size() - length);
+                for (size_t i = 0; i < length; ++i) {
+                    out += gen() % 50 == 0 ? bases[gen() % 4] : out[start + i];
+                }
+            } else {
+                for (size_t i = 0; i < 100; ++i) out += bases[gen() % 4];
+            }
+        }
+        out.resize(size);
+        return out;
+    }
+
+    // fixed size binary records of small integers and floats with many zero bytes, like kennedy.xls
+    static std::string records(const size_t size) {
+        std::mt19937 gen(6); // NOLINT
+        std::string out;
+        uint32_t counter = 0;
+        while (out.size() < size) {
+            const uint32_t values[4] = {counter++, static_cast<uint32_t>(gen() % 256),
+                                        static_cast<uint32_t>(gen() % 10 == 0 ? gen() : 0), 0x3F800000};
+            const float measurement = static_cast<float>(gen() % 10000) / 100.0f;
+            out.append(reinterpret_cast<const char*>(values), sizeof(values));
+            out.append(reinterpret_cast<const char*>(&measurement), sizeof(measurement));
+            out.append(12, '\0');
+        }
+        out.resize(size);
+        return out;
+    }
+
+    // black and white bitmap of a scanned page, mostly white with short black runs, like ptt5
+    static std::string bitmap(const size_t size) {
+        std::mt19937 gen(7); // NOLINT
+        constexpr size_t rowBytes = 216; // 1728 pixels
+        std::string out;
+        std::string row(rowBytes, '\0');
+        while (out.size() < size) {
+            // text lines of black pixels separated by blank rows
+            if (gen() % 3 == 0) {
+                for (char& c : row) c = gen() % 6 == 0 ? static_cast<char>(gen()) : '\0';
+            } else if (gen() % 2 == 0) {
+                row.assign(rowBytes, '\0');
+            }
+            out += row;
+        }
+        out.resize(size);
+        return out;
+    }
+
+    // incompressible bytes
+    static std::string random(const size_t size) {
+        std::mt19937 gen(8); // NOLINT
+        std::string out(size, '\0');
+        for (char& c : out) c = static_cast<char>(gen());
+        return out;
+    }
+}
+
+static const std::vector<CorpusFile>& corpusFiles() {
+    static const std::vector<CorpusFile> files = {
+            {"alice.txt", "English-like prose", generate::text},
+            {"source.c", "C-like source code", generate::source},
+            {"records.xml", "XML records", generate::markup},
+            {"server.log", "web server log", generate::log},
+            {"ecoli.dna", "nucleotides with repeats", generate::dna},
+            {"table.bin", "binary records", generate::records},
+            {"page.pbm", "sparse bitmap", generate::bitmap},
+            {"random.bin", "random bytes", generate::random},
+    };
+    return files;
+}
+
+static const std::vector<Codec>& codecs() {
+    static const std::vector<Codec> all = {
+            {"huffman", "", ".huffman"},
+            {"lzw", "-l", ".lzw"},
+            {"bwmh", "-b", ".bwmh"},
+    };
+    return all;
+}
+
+struct Run {
+    double seconds;
+    long maxRssKiB;
+};
+
+// run the command in a child process with its standard output discarded
+// the peak RSS includes the memory of this process when it forked, which is why the corpus is not kept in memory
+static Run run(const std::vector<std::string>& command) {
+    std::vector<char*> argv;
+    for (const std::string& arg : command) argv.push_back(const_cast<char*>(arg.c_str()));
+    argv.push_back(nullptr);
+
+    const auto start = std::chrono::steady_clock::now();
+    const pid_t pid = fork();
+    if (pid < 0) throw std::runtime_error("Cannot fork");
+    if (pid == 0) {
+        const int devNull = open("/dev/null", O_WRONLY);
+        if (devNull >= 0) dup2(devNull, STDOUT_FILENO);
+        execv(argv[0], argv.data());
+        _exit(127);
+    }
+    int status = 0;
+    rusage usage{};
+    if (wait4(pid, &status, 0, &usage) != pid) throw std::runtime_error("Cannot wait for " + command[0]);
+    const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+        std::string line;
+        for (const std::string& arg : command) line += " " + arg;
+        throw std::runtime_error("Command failed:" + line);
+    }
+    return {elapsed.count(), usage.ru_maxrss}; // KiB on Linux
+}
+
+static uint64_t fileSize(const std::string& path) {
+    struct stat st{};
+    if (stat(path.c_str(), &st) != 0) throw std::runtime_error("Cannot read " + path);
+    return static_cast<uint64_t>(st.st_size);
+}
+
+static bool sameContent(const std::string& path1, const std::string& path2) {
+    std::ifstream ifs1(path1, std::ios::binary), ifs2(path2, std::ios::binary);
+    std::string buf1(1 << 16, '\0'), buf2(1 << 16, '\0');
+    while (ifs1 && ifs2) {
+        ifs1.read(buf1.data(), static_cast<std::streamsize>(buf1.size()));
+        ifs2.read(buf2.data(), static_cast<std::streamsize>(buf2.size()));
+        if (ifs1.gcount() != ifs2.gcount()
+            || buf1.compare(0, static_cast<size_t>(ifs1.gcount()), buf2, 0, static_cast<size_t>(ifs2.gcount())) != 0) {
+            return false;
+        }
+    }
+    return !ifs1 && !ifs2;
+}
+
+// compress and extract the file with the codec, keeping the fastest of the repetitions and the largest RSS
+static Result measure(const std::string& executable, const std::vector<std::string>& options,
+                      const std::string& path, const std::string& name, const Codec& codec, const size_t repetitions) {
+    Result result{name, codec.name};
+    result.size = fileSize(path);
+    const std::string compressed = path + codec.extension;
+    for (size_t i = 0; i < repetitions; ++i) {
+        std::vector<std::string> command = {executable};
+        command.insert(command.end(), options.begin(), options.end());
+        if (!codec.flag.empty()) command.push_back(codec.flag);
+        command.push_back(path);
+        const Run compress = run(command);
+
+        command.back() = "-x";
+        command.push_back(compressed);
+        const Run expand = run(command);
+        if (!sameContent(path, compressed + ".orig")) {
+            throw std::runtime_error("Extracted file differs from " + path + " with " + codec.name);
+        }
+
+        result.compressedSize = fileSize(compressed);
+        result.compressSeconds = i == 0 ? compress.seconds : std::min(result.compressSeconds, compress.seconds);
+        result.expandSeconds = i == 0 ? expand.seconds : std::min(result.expandSeconds, expand.seconds);
+        result.compressRssKiB = std::max(result.compressRssKiB, compress.maxRssKiB);
+        result.expandRssKiB = std::max(result.expandRssKiB, expand.maxRssKiB);
+    }
+    std::remove(compressed.c_str());
+    std::remove((compressed + ".orig").c_str());
+    return result;
+}
+
+static void printTable(std::ostream& os, const std::vector<Result>& results) {
+    os << std::left << std::setw(14) << "file" << std::setw(9) << "codec" << std::right << std::setw(10) << "size"
+       << std::setw(11) << "compressed" << std::setw(8) << "ratio" << std::setw(7) << "bpb"
+       << std::setw(11) << "comp MB/s" << std::setw(11) << "exp MB/s"
+       << std::setw(14) << "comp RSS KiB" << std::setw(13) << "exp RSS KiB" << "\n";
+    os << std::fixed;
+    const auto printRow = [&os](const Result& r) {
+        os << std::left << std::setw(14) << r.file << std::setw(9) << r.codec << std::right
+           << std::setw(10) << r.size << std::setw(11) << r.compressedSize << std::setprecision(2)
+           << std::setw(8) << r.ratio() << std::setprecision(3)
+           << std::setw(7) << 8.0 * static_cast<double>(r.compressedSize) / static_cast<double>(r.size)
+           << std::setprecision(1) << std::setw(11) << r.compressMBps() << std::setw(11) << r.expandMBps()
+           << std::setw(14) << r.compressRssKiB << std::setw(13) << r.expandRssKiB << "\n";
+    };
+    for (const Result& r : results) printRow(r);
+
+    // the whole corpus per codec
+    os << "\n";
+    for (const Codec& codec : codecs()) {
+        Result total{"total", codec.name};
+        for (const Result& r : results) {
+            if (r.codec != codec.name) continue;
+            total.size += r.size;
+            total.compressedSize += r.compressedSize;
+            total.compressSeconds += r.compressSeconds;
+            total.expandSeconds += r.expandSeconds;
+            total.compressRssKiB = std::max(total.compressRssKiB, r.compressRssKiB);
+            total.expandRssKiB = std::max(total.expandRssKiB, r.expandRssKiB);
+        }
+        if (total.size > 0) printRow(total);
+    }
+    os.unsetf(std::ios::fixed);
+}
+
+static void writeJson(std::ostream& os, const std::vector<Result>& results) {
+    os << "{\n  \"results\": [\n" << std::setprecision(6);
+    for (size_t i = 0; i < results.size(); ++i) {
+        const Result& r = results[i];
+        os << "    {\"file\": \"" << r.file << "\", \"codec\": \"" << r.codec << "\", \"size\": " << r.size
+           << ", \"compressedSize\": " << r.compressedSize << ", \"compressSeconds\": " << r.compressSeconds
+           << ", \"expandSeconds\": " << r.expandSeconds << ", \"compressRssKiB\": " << r.compressRssKiB
+           << ", \"expandRssKiB\": " << r.expandRssKiB << "}" << (i + 1 < results.size() ? "," : "") << "\n";
+    }
+    os << "  ]\n}\n";
+}
+
+// read the results of writeJson: objects with string and number values, nothing nested
+static std::vector<Result> readJson(std::istream& is) {
+    const std::string json(std::istreambuf_iterator<char>(is), {});
+    std::vector<Result> results;
+    size_t pos = json.find("\"results\"");
+    if (pos == std::string::npos) throw std::runtime_error("Baseline has no results");
+    while ((pos = json.find('{', pos)) != std::string::npos) {
+        const size_t end = json.find('}', pos);
+        if (end == std::string::npos) throw std::runtime_error("Unterminated object in baseline");
+        std::map<std::string, std::string> values;
+        size_t p = pos + 1;
+        while (true) {
+            const size_t keyStart = json.find('"', p);
+            if (keyStart == std::string::npos || keyStart > end) break;
+            const size_t keyEnd = json.find('"', keyStart + 1);
+            const size_t colon = json.find(':', keyEnd);
+            size_t valueStart = json.find_first_not_of(" \t\n", colon + 1);
+            size_t valueEnd;
+            if (json[valueStart] == '"') {
+                ++valueStart;
+                valueEnd = json.find('"', valueStart);
+                p = valueEnd + 1;
+            } else {
+                valueEnd = json.find_first_of(",} \t\n", valueStart);
+                p = valueEnd;
+            }
+            values[json.substr(keyStart + 1, keyEnd - keyStart - 1)] = json.substr(valueStart, valueEnd - valueStart);
+        }
+        Result r{values["file"], values["codec"]};
+        r.size = std::stoull(values["size"]);
+        r.compressedSize = std::stoull(values["compressedSize"]);
+        r.compressSeconds = std::stod(values["compressSeconds"]);
+        r.expandSeconds = std::stod(values["expandSeconds"]);
+        r.compressRssKiB = std::stol(values["compressRssKiB"]);
+        r.expandRssKiB = std::stol(values["expandRssKiB"]);
+        results.push_back(r);
+        pos = end + 1;
+    }
+    return results;
+}
+
+// relative change in percent from the baseline
+static double change(const double baseline, const double current) {
+    return baseline != 0 ? 100.0 * (current - baseline) / baseline : 0;
+}
+
+// print the changes to the baseline and mark regressions: larger output, lower speed or larger RSS by more than
+// tolerance percent (the size is deterministic, so any increase is a regression)
+// @return number of regressions
+static size_t compare(std::ostream& os, const std::vector<Result>& baseline, const std::vector<Result>& results,
+                      const double tolerance) {
+    os << std::fixed << std::setprecision(1);
+    os << "\nChange to baseline in % (! marks a regression, tolerance " << tolerance << " %):\n";
+    os << std::left << std::setw(14) << "file" << std::setw(9) << "codec" << std::right << std::setw(11)
+       << "compressed" << std::setw(11) << "comp MB/s" << std::setw(11) << "exp MB/s"
+       << std::setw(14) << "comp RSS" << std::setw(13) << "exp RSS" << "\n";
+    size_t numRegressions = 0;
+    const auto cell = [&](const int width, const double value, const bool regression) {
+        numRegressions += regression;
+        os << std::setw(width - 1) << value << (regression ? "!" : " ");
+    };
+    for (const Result& r : results) {
+        const auto it = std::find_if(baseline.begin(), baseline.end(), [&r](const Result& b) {
+            return b.file == r.file && b.codec == r.codec && b.size == r.size;
+        });
+        os << std::left << std::setw(14) << r.file << std::setw(9) << r.codec << std::right;
+        if (it == baseline.end()) {
+            os << "  not in baseline\n";
+            continue;
+        }
+        const double size = change(static_cast<double>(it->compressedSize), static_cast<double>(r.compressedSize));
+        const double comp = change(it->compressMBps(), r.compressMBps());
+        const double exp = change(it->expandMBps(), r.expandMBps());
+        const double compRss = change(static_cast<double>(it->compressRssKiB), static_cast<double>(r.compressRssKiB));
+        const double expRss = change(static_cast<double>(it->expandRssKiB), static_cast<double>(r.expandRssKiB));
+        cell(11, size, r.compressedSize > it->compressedSize);
+        cell(11, comp, comp < -tolerance);
+        cell(11, exp, exp < -tolerance);
+        cell(14, compRss, compRss > tolerance);
+        cell(13, expRss, expRss > tolerance);
+        os << "\n";
+    }
+    os.unsetf(std::ios::fixed);
+    return numRegressions;
+}
+
+int main(int argc, char** argv) {
+    argagg::parser argparser{{
+                                     {"help", {"-h", "--help"}, "Show this help message", 0},
+                                     {"compress", {"-c", "--compress"}, "Path of the compress executable (default: the one of this build)", 1},
+                                     {"dir", {"-d", "--dir"}, "Directory for the corpus and the compressed files (default: corpus)", 1},
+                                     {"size", {"-s", "--size"}, "Size of each corpus file in KiB (default: 1024)", 1},
+                                     {"repetitions", {"-r", "--repetitions"}, "Number of runs per file and codec, the fastest is reported (default: 3)", 1},
+                                     {"threads", {"-T", "--threads"}, "Number of threads of compress (default: 1)", 1},
+                                     {"json", {"-j", "--json"}, "Write the results as JSON to this file", 1},
+                                     {"baseline", {"--baseline"}, "Compare with the results in this JSON file, the exit code is 2 if there are regressions", 1},
+                                     {"tolerance", {"--tolerance"}, "Change of speed and memory in percent that is not a regression (default: 10)", 1},
+                                     {"filter", {"-f", "--filter"}, "Only run files or codecs whose name contains this string", 1},
+                             }};
+    argagg::parser_results args;
+    try {
+        args = argparser.parse(argc, argv);
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << '\n';
+        return EXIT_FAILURE;
+    }
+    if (args["help"] || !args.pos.empty()) {
+        argagg::fmt_ostream fmt(std::cerr);
+        fmt << "Usage: " << argv[0] << " [options]\n" << argparser;
+        fmt << "\nExamples:\n";
+        fmt << argv[0] << " --json baseline.json\t\tMeasure and store the results\n";
+        fmt << argv[0] << " --baseline baseline.json\tCompare with stored results\n";
+        return 1;
+    }
+
+    try {
+        const std::string executable = args["compress"].as<std::string>(COMPRESS_EXECUTABLE);
+        const std::string dir = args["dir"].as<std::string>("corpus");
+        const size_t size = args["size"].as<size_t>(1024) << 10;
+        const size_t repetitions = std::max<size_t>(1, args["repetitions"].as<size_t>(3));
+        const double tolerance = args["tolerance"].as<double>(10);
+        const std::string filter = args["filter"].as<std::string>("");
+        std::vector<std::string> options;
+        if (args["threads"]) options = {"-T", args["threads"].as<std::string>()};
+
+        // the baseline is read first, so a wrong path does not waste a whole run
+        std::vector<Result> baseline;
+        if (args["baseline"]) {
+            std::ifstream ifs(args["baseline"].as<std::string>());
+            if (!ifs) throw std::runtime_error("Cannot open baseline " + args["baseline"].as<std::string>());
+            baseline = readJson(ifs);
+        }
+
+        mkdir(dir.c_str(), 0755);
+        std::vector<Result> results;
+        for (const CorpusFile& file : corpusFiles()) {
+            const std::string path = dir + "/" + file.name;
+            {
+                // generated for each run, so files from a run with another size are not used
+                const std::string data = file.generate(size);
+                std::ofstream ofs(path, std::ios::binary);
+                ofs.write(data.data(), static_cast<std::streamsize>(data.size()));
+                if (!ofs) throw std::runtime_error("Cannot write " + path);
+            }
+            for (const Codec& codec : codecs()) {
+                if (filter.empty() || file.name.find(filter) != std::string::npos
+                    || codec.name.find(filter) != std::string::npos) {
+                    std::cerr << "Running " << codec.name << " on " << file.name << " (" << file.description
+                              << ")...\n";
+                    results.push_back(measure(executable, options, path, file.name, codec, repetitions));
+                }
+            }
+        }
+
+        printTable(std::cout, results);
+        if (args["json"]) {
+            std::ofstream ofs(args["json"].as<std::string>());
+            writeJson(ofs, results);
+            if (!ofs) throw std::runtime_error("Cannot write " + args["json"].as<std::string>());
+        }
+        if (args["baseline"] && compare(std::cout, baseline, results, tolerance) > 0) return 2;
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << '\n';
+        return EXIT_FAILURE;
+    }
+    return 0;
+}
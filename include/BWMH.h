@@ -0,0 +1,75 @@
+#ifndef COMPRESSION_CPP_BWMH_H
+#define COMPRESSION_CPP_BWMH_H
+
+#include <istream>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include "BurrowsWheeler.h"
+#include "MoveToFront.h"
+#include "ZeroRun.h"
+#include "Huffman.h"
+#include "BlockStream.h"
+
+// Burrows-Wheeler transform, move-to-front transform, zero-run encoding and Huffman compression applied to
+// independent blocks
+namespace bwmh {
+    constexpr static size_t defaultBlockSize = size_t{1} << 20; // 1 MiB
+
+    // compress a single block (including the Burrows-Wheeler index)
+    // each stage works on a buffer owned by the pipeline, move-to-front transforms it in place
+    [[maybe_unused]]
+    static std::string compressBlock(const std::string_view input) {
+        std::string buf = bw::encode(input);
+        mtf::encode(buf);
+        return huffman::compressSymbolsMultiTable<zero_run::numSymbols>(zero_run::encode(buf));
+    }
+
+    // expand a single block that was compressed with compressBlock
+    // @param version version of the block stream the block was written with: version 3 used a single Huffman table,
+    //                before version 3, the move-to-front output was compressed directly, version 1 and files without
+    //                header use the Huffman trie format
+    [[maybe_unused]]
+    static std::string expandBlock(const std::string_view input, const uint8_t version = block::version) {
+        constexpr size_t maxSize = block::maxBlockSize + 4; // Burrows-Wheeler output of the largest block
+        std::string buf;
+        if (version >= 4) {
+            buf = zero_run::decode(huffman::expandSymbolsMultiTable<zero_run::numSymbols>(input), maxSize);
+        } else if (version == 3) {
+            buf = zero_run::decode(huffman::expandSymbols<zero_run::numSymbols>(input), maxSize);
+        } else {
+            buf = huffman::expand(input, version >= 2 ? huffman::Format::Canonical : huffman::Format::Trie);
+        }
+        mtf::decode(buf);
+        return bw::decode(buf);
+    }
+
+    // compress input in blocks of blockSize bytes, so memory usage does not grow with input size
+    [[maybe_unused]]
+    static void compress(std::istream& is, std::ostream& os, const size_t blockSize = defaultBlockSize,
+                         const size_t numThreads = 1) {
+        block::compress(is, os, blockSize, compressBlock, numThreads, block::CodecId::BWMH);
+    }
+
+    // expand input that was compressed with compress
+    // @param verify check the checksums of the blocks
+    [[maybe_unused]]
+    static void expand(std::istream& is, std::ostream& os, const size_t numThreads = 1, const bool verify = true) {
+        block::expand(is, os, [](const uint8_t version) -> block::BlockCodec {
+            return [version](const std::string& in) { return expandBlock(in, version); };
+        }, numThreads, verify);
+    }
+
+    // expand length bytes starting at offset of the original input, only the blocks containing them are expanded
+    // the input stream has to be seekable
+    [[maybe_unused]]
+    static void expandRange(std::istream& is, std::ostream& os, const uint64_t offset, const uint64_t length,
+                            const size_t numThreads = 1, const bool verify = true) {
+        const block::Index index = block::readIndex(is);
+        const uint8_t version = index.header.version;
+        block::expandRange(is, os, index, offset, length,
+                           [version](const std::string& in) { return expandBlock(in, version); }, numThreads, verify);
+    }
+} // bwmh
+
+#endif //COMPRESSION_CPP_BWMH_H
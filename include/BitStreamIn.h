@@ -3,24 +3,29 @@
 
 #include <istream>
 #include <cstdint>
+#include <cstring>
+#include <memory>
+#include <algorithm>
 #include <ShortBitSet.h>
 
 // Wrapper for easy reading of bits from std::istream
+// The stream is read in chunks of bufferSize bytes, so its position after reading bits is not defined
 class BitStreamIn {
 public:
-    explicit BitStreamIn(std::istream& _is) : is{_is} {}
+    constexpr static size_t bufferSize = 64 * 1024;
+
+    // the buffer is not initialized, so reading a short message does not pay for clearing all of it
+    explicit BitStreamIn(std::istream& _is) : is{_is}, buffer(new char[bufferSize]) {}
     BitStreamIn() = delete;
     BitStreamIn(BitStreamIn&& rhs) = delete;
     BitStreamIn(const BitStreamIn& rhs) = delete;
     BitStreamIn& operator=(const BitStreamIn& rhs) = delete;
 
-    void skip(const size_t numBits) {
-        for (size_t skipped=0; skipped < numBits; ++skipped) {
-            if (fullByte()) {
-                advance();
-                checkFinished();
-            }
-            ++idx;
+    void skip(size_t numBits) {
+        while (numBits > 0) {
+            const size_t n = std::min(numBits, maxChunk);
+            (void) readBits(n);
+            numBits -= n;
         }
     }
 
@@ -38,18 +43,14 @@ public:
             bitsToRead -= numSkip;
         }
 
-        T val = 0;
-        while (bitsToRead-- > 0) {
-            // bitsToRead is also offset
-            if (fullByte()) {
-                advance();
-                checkFinished();
-            }
-            ++idx;
-            val |= static_cast<T>(currentBool() << bitsToRead);
+        uint64_t val = 0;
+        while (bitsToRead > 0) {
+            const size_t n = std::min(bitsToRead, maxChunk);
+            val = (val << n) | readBits(n);
+            bitsToRead -= n;
         }
 
-        return val;
+        return static_cast<T>(val);
     }
 
     // read a boolean value
@@ -57,15 +58,7 @@ public:
     bool readBool(const size_t totalLengthBits = 1) {
         if (totalLengthBits < 1) throw std::invalid_argument("Bool read needs at least one bit");
         skip(totalLengthBits - 1);
-
-        if (fullByte()) {
-            advance();
-            checkFinished();
-        }
-        ++idx;
-        bool val = currentBool();
-
-        return val;
+        return readBits(1);
     }
 
     // read ShortBitSet
@@ -77,57 +70,89 @@ public:
             bitsToRead -= numSkip;
         }
 
+        const uint32_t val = readBits(bitsToRead);
         ShortBitSet bs;
         while (bitsToRead-- > 0) {
             // bitsToRead is also offset
-            if (fullByte()) {
-                advance();
-                checkFinished();
-            }
-            ++idx;
-            bs.push_back(currentBool());
+            bs.push_back(val & (uint32_t{1} << bitsToRead));
         }
 
         return bs;
     }
 
+    // return the next numBits (0 to 32) bits without consuming them, with the first bit as MSB
+    // bits after the end of the stream are returned as 0
+    [[nodiscard]]
+    uint32_t peekBits(const size_t numBits) {
+        if (numAvailable < numBits) refill();
+        return static_cast<uint32_t>((bits >> 1) >> (63 - numBits)); // two shifts so that numBits=0 is defined
+    }
+
+    // consume numBits (0 to 32) bits that were peeked before
+    void consumeBits(const size_t numBits) {
+        if (numAvailable < numBits) throw std::runtime_error("Stream finished unexpectedly");
+        bits <<= numBits;
+        numAvailable -= numBits;
+    }
+
+    // read and consume the next numBits (0 to 32) bits, with the first bit as MSB
+    uint32_t readBits(const size_t numBits) {
+        const uint32_t val = peekBits(numBits);
+        consumeBits(numBits);
+        return val;
+    }
+
     ~BitStreamIn() = default;
 private:
+    constexpr static size_t maxChunk = 32; // maximum number of bits that are read at once
+
     std::istream& is; // input stream
-    uint8_t curr = 0; // last byte that was read (except if none were read yet)
-    size_t idx = 7; // idx%8 is the last index in curr that was read (except if nothing was read yet)
-    bool finished = false;
-
-    // try to read next byte in stream
-    void advance() {
-        if (finished) throw std::runtime_error("Cannot read if already finished");
-        if (idx%8 != 7) throw std::invalid_argument("Cannot advance if current buffer was not fully used yet");
-
-        char val;
-        if (is.read(&val, 1)) {
-            curr = val;
+    std::unique_ptr<char[]> buffer; // bufferSize bytes read from is
+    size_t bufferPos = 0; // next byte in buffer that was not moved to bits yet
+    size_t bufferEnd = 0; // number of valid bytes in buffer
+    uint64_t bits = 0; // next bits, first bit is the MSB; bits after numAvailable are either the correct next bits or 0
+    size_t numAvailable = 0; // number of valid bits in bits
+
+    // move as many full bytes as possible from the buffer to bits, refilling the buffer from the stream if needed
+    void refill() {
+        if (bufferEnd - bufferPos < sizeof(uint64_t)) {
+            refillBuffer();
+        }
+        if (bufferEnd - bufferPos >= sizeof(uint64_t)) {
+            // common case: load 8 bytes at once, the bits that do not fit are loaded again next time
+            uint64_t word;
+            std::memcpy(&word, buffer.get() + bufferPos, sizeof(word));
+            bits |= toBigEndian(word) >> numAvailable;
+            const size_t numBytes = (63 - numAvailable) / 8;
+            bufferPos += numBytes;
+            numAvailable += 8 * numBytes;
         } else {
-            finished = true;
+            // end of stream: load remaining bytes one by one
+            while (numAvailable <= 56 && bufferPos < bufferEnd) {
+                bits |= static_cast<uint64_t>(static_cast<uint8_t>(buffer[bufferPos++])) << (56 - numAvailable);
+                numAvailable += 8;
+            }
         }
     }
 
-    // throw an error if stream is finished
-    void checkFinished() const {
-        if (finished) {
-            throw std::runtime_error("Stream finished unexpectedly");
+    // move unused bytes to the front of the buffer and read as many bytes from the stream as fit
+    void refillBuffer() {
+        const size_t numLeft = bufferEnd - bufferPos;
+        std::memmove(buffer.get(), buffer.get() + bufferPos, numLeft);
+        bufferPos = 0;
+        bufferEnd = numLeft;
+        if (is) {
+            is.read(buffer.get() + bufferEnd, static_cast<std::streamsize>(bufferSize - bufferEnd));
+            bufferEnd += static_cast<size_t>(is.gcount());
         }
     }
 
-    // whether the current 8 bit buffer was fully used
-    [[nodiscard]]
-    bool fullByte() const {
-        return idx%8 == 7;
-    }
-
-    // return value of current/last read byte
-    [[nodiscard]]
-    bool currentBool() const {
-        return curr & (1 << (7-(idx%8)));
+    static uint64_t toBigEndian(const uint64_t val) {
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+        return val;
+#else
+        return __builtin_bswap64(val);
+#endif
     }
 };
 
@@ -3,21 +3,42 @@
 
 #include <ostream>
 #include <cstdint>
+#include <vector>
+#include <algorithm>
+#include <type_traits>
 #include <ShortBitSet.h>
 
 // Wrapper for easy writing of bits to std::ostream
+// Bits are collected in a 64 bit accumulator and written to the stream in chunks of bufferSize bytes, so the
+// stream only contains all bits after flush() (or destruction)
 class BitStreamOut {
 public:
-    explicit BitStreamOut(std::ostream& _os) : os{_os} {}
+    constexpr static size_t bufferSize = 64 * 1024;
+
+    explicit BitStreamOut(std::ostream& _os) : os{_os} {
+        buffer.reserve(bufferSize);
+    }
     BitStreamOut() = delete;
     BitStreamOut(BitStreamOut&& rhs) = delete;
     BitStreamOut(const BitStreamOut& rhs) = delete;
     BitStreamOut& operator=(const BitStreamOut& rhs) = delete;
 
-    void writeEmpty(const size_t totalLength) {
-        for (size_t written=0; written < totalLength; ++written) {
-            ++idx;
-            if (fullByte()) flush();
+    void writeEmpty(size_t totalLength) {
+        while (totalLength > 0) {
+            const size_t n = std::min(totalLength, maxChunk);
+            writeBits(0, n);
+            totalLength -= n;
+        }
+    }
+
+    // write the lowest numBits (at most 32) bits of val
+    void writeBits(const uint32_t val, const size_t numBits) {
+        if (numBits == 0) return;
+        const uint64_t masked = val & ((uint64_t{1} << numBits) - 1);
+        acc |= masked << (64 - numAcc - numBits); // numAcc < 32 before, so this cannot overflow
+        numAcc += numBits;
+        if (numAcc >= 32) {
+            drainWord();
         }
     }
 
@@ -31,46 +52,37 @@ public:
         size_t bitsToWrite = totalLengthBits;
         if (bitsToWrite > numBitsFull) {
             writeEmpty(totalLengthBits - numBitsFull);
-            bitsToWrite -= numBitsFull;
+            bitsToWrite = numBitsFull;
         }
 
-        while (bitsToWrite-- > 0) {
+        const auto bits = static_cast<uint64_t>(static_cast<std::make_unsigned_t<T>>(val));
+        while (bitsToWrite > 0) {
             // bitsToWrite is also offset
-            curr |= ( (val & (static_cast<T>(1) << bitsToWrite)) >> bitsToWrite ) << (7 - idx);
-            ++idx;
-            if (fullByte()) flush();
+            const size_t n = std::min(bitsToWrite, maxChunk);
+            bitsToWrite -= n;
+            writeBits(static_cast<uint32_t>(bits >> bitsToWrite), n);
         }
     }
 
     void write(const bool val, const size_t totalLengthBits = 1) {
         if (totalLengthBits < 1) throw std::invalid_argument("Bool write needs at least one bit");
         writeEmpty(totalLengthBits - 1);
-
-        if (val) {
-            curr |= 1 << (7 - idx);
-        }
-        ++idx;
-
-        if (fullByte()) flush();
+        writeBits(val, 1);
     }
 
     // write all bits of ShortBitSet
     void write(const ShortBitSet& bs) {
-        for (size_t i=0; i < bs.size(); ++i) {
-            if (bs.at(i)) {
-                curr |= 1 << (7 - idx);
-            }
-            ++idx;
-            if (fullByte()) flush();
-        }
+        writeBits(bs.value(), bs.size());
     }
 
-    // force to write out current buffer (except if empty)
+    // force to write out all bits, filling up the last byte with zeros (except if empty)
     void flush() {
-        if (idx == 0) return;
-        os.write(reinterpret_cast<char*>(&curr), 1);
-        curr = 0;
-        idx = 0;
+        while (numAcc > 0) {
+            buffer.push_back(static_cast<char>(acc >> 56));
+            acc <<= 8;
+            numAcc = numAcc >= 8 ? numAcc - 8 : 0;
+        }
+        writeBuffer();
     }
 
     ~BitStreamOut() {
@@ -78,14 +90,30 @@ public:
         flush();
     }
 private:
+    constexpr static size_t maxChunk = 32; // maximum number of bits that are added to acc at once
+
     std::ostream& os; // output stream
-    uint8_t curr = 0; // buffer of length 8 bits
-    size_t idx = 0; // next index in buffer that can be written
+    uint64_t acc = 0; // bits that were not moved to buffer yet, first bit is the MSB
+    size_t numAcc = 0; // number of valid bits in acc, less than 32 between calls
+    std::vector<char> buffer; // full bytes that were not written to os yet
+
+    // move the upper 32 bits of acc to buffer
+    void drainWord() {
+        const auto word = static_cast<uint32_t>(acc >> 32);
+        const char bytes[4] = {static_cast<char>(word >> 24), static_cast<char>(word >> 16),
+                               static_cast<char>(word >> 8), static_cast<char>(word)};
+        buffer.insert(buffer.end(), bytes, bytes + 4);
+        acc <<= 32;
+        numAcc -= 32;
+        if (buffer.size() >= bufferSize) {
+            writeBuffer();
+        }
+    }
 
-    // whether the current 8 bit buffer is full
-    [[nodiscard]]
-    bool fullByte() const {
-        return idx == 8;
+    void writeBuffer() {
+        if (buffer.empty()) return;
+        os.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+        buffer.clear();
     }
 };
 
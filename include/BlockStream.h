@@ -0,0 +1,515 @@
+#ifndef COMPRESSION_CPP_BLOCKSTREAM_H
+#define COMPRESSION_CPP_BLOCKSTREAM_H
+
+#include <istream>
+#include <ostream>
+#include <string>
+#include <array>
+#include <functional>
+#include <algorithm>
+#include <deque>
+#include <future>
+#include <stdexcept>
+#include <cstdint>
+#include <vector>
+#include <type_traits>
+#include "ThreadPool.h"
+#include "CRC32C.h"
+#include "Stats.h"
+
+// Stream of independently compressed blocks:
+//   header: magic (4 bytes) + format version (1 byte)
+//   blocks: size of the compressed block (32 bit, big endian) + compressed block, repeated until end of stream
+// Since version 5, the stream is framed so that the codec is known and blocks can be checked and found:
+//   header: magic (4 bytes) + format version (1 byte) + codec id (1 byte) + block size (32 bit)
+//   blocks: compressed size, uncompressed size and CRC32C of the uncompressed data (32 bit each) + compressed block,
+//           repeated until endOfBlocks instead of a compressed size
+//   index:  number of blocks (32 bit), then for each block the offset of its frame in the stream and of its data in
+//           the uncompressed data (64 bit each), its compressed and uncompressed sizes and CRC32C (32 bit each)
+//   trailer: offset of the index in the stream (64 bit) + uncompressed size (64 bit) + indexMagic (4 bytes)
+// All integers are big endian.
+// Versions: 1 = Huffman data uses huffman::Format::Trie, 2 = Huffman data uses huffman::Format::Canonical,
+//           3 = Burrows-Wheeler blocks encode runs of zeros before Huffman compression,
+//           4 = Burrows-Wheeler blocks use several Huffman tables, 5 = framed stream
+namespace block {
+    constexpr static std::array<char, 4> magic = {'C', 'C', 'P', 'B'};
+    constexpr static std::array<char, 4> indexMagic = {'C', 'C', 'P', 'I'};
+    constexpr static uint8_t version = 5;
+    constexpr static uint8_t firstFramedVersion = 5;
+    constexpr static size_t maxBlockSize = size_t{1} << 30; // 1 GiB
+    constexpr static uint32_t endOfBlocks = 0xFFFFFFFF; // compressed size that marks the end of the blocks
+    constexpr static size_t trailerSize = 8 + 8 + indexMagic.size();
+
+    // codec of the blocks of a framed stream
+    enum class CodecId : uint8_t {
+        None = 0, // unknown, e.g. for custom codecs
+        Huffman = 1,
+        LZW = 2,
+        BWMH = 3,
+    };
+
+    // header of a block stream
+    struct Header {
+        uint8_t version = 0; // 0 if there is no header
+        CodecId codec = CodecId::None; // only known since version 5
+        uint32_t blockSize = 0; // only known since version 5
+
+        explicit operator bool() const { return version != 0; }
+    };
+
+    // entry of the index of a framed stream
+    struct IndexEntry {
+        uint64_t offset; // of the frame of the block in the stream
+        uint64_t uncompressedOffset; // of the data of the block in the uncompressed data
+        uint32_t compressedSize;
+        uint32_t uncompressedSize;
+        uint32_t crc; // CRC32C of the uncompressed data
+
+        bool operator==(const IndexEntry& rhs) const {
+            return offset == rhs.offset && uncompressedOffset == rhs.uncompressedOffset
+                   && compressedSize == rhs.compressedSize && uncompressedSize == rhs.uncompressedSize
+                   && crc == rhs.crc;
+        }
+    };
+
+    // header and index of a framed stream
+    struct Index {
+        Header header;
+        std::vector<IndexEntry> entries;
+        uint64_t uncompressedSize = 0;
+        std::streamoff start = 0; // position of the stream in the file, to which the offsets of the entries refer
+    };
+
+    // function that compresses or expands a single block
+    using BlockCodec = std::function<std::string(const std::string&)>;
+
+    namespace internal {
+        constexpr static size_t headerSize = magic.size() + 1 + 1 + 4; // of a framed stream
+        constexpr static size_t frameHeaderSize = 3 * 4;
+        constexpr static size_t indexEntrySize = 8 + 8 + 3 * 4;
+        constexpr static size_t readChunkSize = size_t{1} << 20;
+
+        // largest compressed size of a block of a stream with the given block size that is accepted when reading,
+        // generous for all codecs: LZW codes of up to 24 bits need at most 3 bytes per input byte
+        constexpr uint64_t maxCompressedSize(const uint32_t blockSize) {
+            return std::min<uint64_t>(4 * uint64_t{blockSize} + 64 * 1024, endOfBlocks - 1);
+        }
+
+        // data of a block and its frame
+        struct Frame {
+            std::string data;
+            uint32_t uncompressedSize = 0;
+            uint32_t crc = 0;
+        };
+
+        // block whose expanded data is only needed from first to last (exclusive)
+        struct FrameSlice {
+            Frame frame;
+            size_t first = 0;
+            size_t last = 0;
+        };
+
+        [[maybe_unused]]
+        static void writeUInt32(std::ostream& os, const uint32_t val) {
+            const char bytes[4] = {static_cast<char>(val >> 24), static_cast<char>(val >> 16),
+                                   static_cast<char>(val >> 8), static_cast<char>(val)};
+            os.write(bytes, 4);
+        }
+
+        [[maybe_unused]]
+        static void writeUInt64(std::ostream& os, const uint64_t val) {
+            writeUInt32(os, static_cast<uint32_t>(val >> 32));
+            writeUInt32(os, static_cast<uint32_t>(val));
+        }
+
+        // read a 32 bit value
+        // @return false if the stream ended before the first byte
+        [[maybe_unused]]
+        static bool readUInt32(std::istream& is, uint32_t& val) {
+            unsigned char bytes[4];
+            is.read(reinterpret_cast<char*>(bytes), 4);
+            if (is.gcount() == 0) return false;
+            if (is.gcount() != 4) throw std::runtime_error("Stream finished unexpectedly");
+            val = (uint32_t{bytes[0]} << 24) | (uint32_t{bytes[1]} << 16) | (uint32_t{bytes[2]} << 8) | bytes[3];
+            return true;
+        }
+
+        // read a 32 bit value that has to be present
+        [[maybe_unused]]
+        static uint32_t readUInt32(std::istream& is) {
+            uint32_t val;
+            if (!readUInt32(is, val)) throw std::runtime_error("Stream finished unexpectedly");
+            return val;
+        }
+
+        [[maybe_unused]]
+        static uint64_t readUInt64(std::istream& is) {
+            const uint64_t high = readUInt32(is);
+            return (high << 32) | readUInt32(is);
+        }
+
+        // read up to size bytes into buf
+        // the buffer grows in chunks, so that a wrong size does not allocate much more than the stream holds
+        // @return false if no bytes could be read
+        [[maybe_unused]]
+        static bool readBlock(std::istream& is, std::string& buf, const size_t size) {
+            buf.clear();
+            while (buf.size() < size) {
+                const size_t numRead = buf.size();
+                const size_t chunk = std::min(readChunkSize, size - numRead);
+                buf.resize(numRead + chunk);
+                is.read(buf.data() + numRead, static_cast<std::streamsize>(chunk));
+                buf.resize(numRead + static_cast<size_t>(is.gcount()));
+                if (buf.size() < numRead + chunk) break;
+            }
+            return !buf.empty();
+        }
+
+        [[maybe_unused]]
+        static void writeIndexEntry(std::ostream& os, const IndexEntry& entry) {
+            writeUInt64(os, entry.offset);
+            writeUInt64(os, entry.uncompressedOffset);
+            writeUInt32(os, entry.compressedSize);
+            writeUInt32(os, entry.uncompressedSize);
+            writeUInt32(os, entry.crc);
+        }
+
+        [[maybe_unused]]
+        static IndexEntry readIndexEntry(std::istream& is) {
+            IndexEntry entry{};
+            entry.offset = readUInt64(is);
+            entry.uncompressedOffset = readUInt64(is);
+            entry.compressedSize = readUInt32(is);
+            entry.uncompressedSize = readUInt32(is);
+            entry.crc = readUInt32(is);
+            return entry;
+        }
+
+        // check the sizes of a frame against the block size of the stream before its data is read
+        [[maybe_unused]]
+        static void checkFrameSizes(const Header& header, const uint32_t compressedSize,
+                                    const uint32_t uncompressedSize) {
+            if (uncompressedSize == 0 || uncompressedSize > header.blockSize
+                || compressedSize > maxCompressedSize(header.blockSize)) {
+                throw std::runtime_error("Invalid frame size, block is corrupted");
+            }
+        }
+
+        // apply codec to all inputs returned by readNext and pass the results to write in the original order
+        // with numThreads > 1, up to 2*numThreads inputs are processed in parallel
+        template<typename Input, typename ReadFn, typename Codec, typename WriteFn>
+        static void process(ReadFn readNext, const Codec& codec, WriteFn write, const size_t numThreads) {
+            using Result = std::invoke_result_t<const Codec&, const Input&>;
+            Input buf;
+            if (numThreads <= 1) {
+                while (readNext(buf)) {
+                    write(codec(buf));
+                }
+                return;
+            }
+
+            ThreadPool pool(numThreads);
+            std::deque<std::future<Result>> pending;
+            auto writeFront = [&pending, &write]() {
+                write(pending.front().get());
+                pending.pop_front();
+            };
+            while (readNext(buf)) {
+                pending.push_back(pool.submit([&codec, input = std::move(buf)] { return codec(input); }));
+                buf = Input();
+                if (pending.size() >= 2*numThreads) writeFront();
+            }
+            while (!pending.empty()) writeFront();
+        }
+    }
+
+    // write the header of a framed stream
+    [[maybe_unused]]
+    static void writeHeader(std::ostream& os, const CodecId codec, const uint32_t blockSize) {
+        os.write(magic.data(), magic.size());
+        os.put(static_cast<char>(version));
+        os.put(static_cast<char>(codec));
+        internal::writeUInt32(os, blockSize);
+    }
+
+    // check whether the stream starts with a block stream header and consume it if so
+    // if not, the stream is rewound to its start, so it has to be seekable
+    [[maybe_unused]]
+    static Header readHeader(std::istream& is) {
+        std::array<char, magic.size()+1> start{};
+        is.read(start.data(), start.size());
+        if (is.gcount() == static_cast<std::streamsize>(start.size())
+            && std::equal(magic.begin(), magic.end(), start.begin())) {
+            Header header;
+            header.version = static_cast<uint8_t>(start.back());
+            if (header.version == 0 || header.version > version) {
+                throw std::runtime_error("Unsupported block stream version");
+            }
+            if (header.version >= firstFramedVersion) {
+                const int codec = is.get();
+                if (codec == std::char_traits<char>::eof() || codec > static_cast<int>(CodecId::BWMH)) {
+                    throw std::runtime_error("Unsupported codec in block stream");
+                }
+                header.codec = static_cast<CodecId>(codec);
+                header.blockSize = internal::readUInt32(is);
+                if (header.blockSize == 0 || header.blockSize > maxBlockSize) {
+                    throw std::runtime_error("Invalid block size in block stream");
+                }
+            }
+            return header;
+        }
+        is.clear();
+        is.seekg(0);
+        return {};
+    }
+
+    // split input into blocks of blockSize bytes, compress each of them and write them as framed stream
+    // the output does not depend on numThreads
+    // @param codec stored in the header, so that the stream can be expanded without knowing it
+    [[maybe_unused]]
+    static void compress(std::istream& is, std::ostream& os, const size_t blockSize, const BlockCodec& compressBlock,
+                         const size_t numThreads = 1, const CodecId codec = CodecId::None) {
+        if (blockSize == 0 || blockSize > maxBlockSize) throw std::invalid_argument("Invalid block size");
+
+        writeHeader(os, codec, static_cast<uint32_t>(blockSize));
+        auto readNext = [&is, blockSize](std::string& buf) {
+            STATS_STAGE(timer, "block.read", 0);
+            const bool read = internal::readBlock(is, buf, blockSize);
+            STATS_OUTPUT(timer, buf.size());
+            return read;
+        };
+        // checksums are computed by the worker threads as well
+        auto compressFrame = [&compressBlock](const std::string& input) {
+            STATS_COUNT(input);
+            uint32_t crc;
+            {
+                STATS_STAGE(timer, "crc32c", input.size());
+                crc = crc32c::compute(input);
+            }
+            return internal::Frame{compressBlock(input), static_cast<uint32_t>(input.size()), crc};
+        };
+        std::vector<IndexEntry> index;
+        uint64_t offset = internal::headerSize;
+        uint64_t uncompressedOffset = 0;
+        auto write = [&os, &index, &offset, &uncompressedOffset, blockSize](const internal::Frame& frame) {
+            STATS_STAGE(timer, "block.write", internal::frameHeaderSize + frame.data.size());
+            STATS_OUTPUT(timer, internal::frameHeaderSize + frame.data.size());
+            // the same limit as for reading, so that every written stream can be expanded
+            if (frame.data.size() > internal::maxCompressedSize(static_cast<uint32_t>(blockSize))) {
+                throw std::runtime_error("Compressed block too large");
+            }
+            const auto compressedSize = static_cast<uint32_t>(frame.data.size());
+            index.push_back({offset, uncompressedOffset, compressedSize, frame.uncompressedSize, frame.crc});
+            internal::writeUInt32(os, compressedSize);
+            internal::writeUInt32(os, frame.uncompressedSize);
+            internal::writeUInt32(os, frame.crc);
+            os.write(frame.data.data(), static_cast<std::streamsize>(frame.data.size()));
+            offset += internal::frameHeaderSize + compressedSize;
+            uncompressedOffset += frame.uncompressedSize;
+        };
+        internal::process<std::string>(readNext, compressFrame, write, numThreads);
+
+        internal::writeUInt32(os, endOfBlocks);
+        const uint64_t indexOffset = offset + 4;
+        internal::writeUInt32(os, static_cast<uint32_t>(index.size()));
+        for (const IndexEntry& entry : index) internal::writeIndexEntry(os, entry);
+        internal::writeUInt64(os, indexOffset);
+        internal::writeUInt64(os, uncompressedOffset);
+        os.write(indexMagic.data(), indexMagic.size());
+    }
+
+    namespace internal {
+        // expand a block and check its size and, if verify is set, its checksum against its frame
+        // errors of the codec are reported as corrupted block, as the data of a valid frame can always be expanded
+        [[maybe_unused]]
+        static std::string expandFrame(const BlockCodec& expandBlock, const Frame& frame, const bool verify = true) {
+            std::string expanded;
+            try {
+                expanded = expandBlock(frame.data);
+            } catch (const std::exception& e) {
+                // also e.g. std::bad_alloc or std::length_error of sizes read from corrupted data
+                throw std::runtime_error(std::string("Block is corrupted: ") + e.what());
+            }
+            STATS_COUNT(expanded);
+            if (expanded.size() != frame.uncompressedSize) throw std::runtime_error("Size mismatch, block is corrupted");
+            if (verify) {
+                STATS_STAGE(timer, "crc32c", expanded.size());
+                if (crc32c::compute(expanded) != frame.crc) {
+                    throw std::runtime_error("Checksum mismatch, block is corrupted");
+                }
+            }
+            return expanded;
+        }
+
+        // expand the blocks of a framed stream, check them against their frames and check the index
+        [[maybe_unused]]
+        static void expandFramed(std::istream& is, std::ostream& os, const Header& header,
+                                 const BlockCodec& expandBlock, const size_t numThreads, const bool verify) {
+            std::vector<IndexEntry> frames;
+            uint64_t offset = headerSize;
+            uint64_t uncompressedOffset = 0;
+            auto readNext = [&is, &header, &frames, &offset, &uncompressedOffset](Frame& frame) {
+                STATS_STAGE(timer, "block.read", 0);
+                const uint32_t size = readUInt32(is);
+                if (size == endOfBlocks) return false;
+                frame.uncompressedSize = readUInt32(is);
+                frame.crc = readUInt32(is);
+                checkFrameSizes(header, size, frame.uncompressedSize);
+                readBlock(is, frame.data, size);
+                if (frame.data.size() != size) throw std::runtime_error("Stream finished unexpectedly");
+                STATS_OUTPUT(timer, frameHeaderSize + size);
+                frames.push_back({offset, uncompressedOffset, size, frame.uncompressedSize, frame.crc});
+                offset += frameHeaderSize + size;
+                uncompressedOffset += frame.uncompressedSize;
+                return true;
+            };
+            auto expand = [&expandBlock, verify](const Frame& frame) { return expandFrame(expandBlock, frame, verify); };
+            auto write = [&os](const std::string& expanded) {
+                STATS_STAGE(timer, "block.write", expanded.size());
+                STATS_OUTPUT(timer, expanded.size());
+                os.write(expanded.data(), static_cast<std::streamsize>(expanded.size()));
+            };
+            process<Frame>(readNext, expand, write, numThreads);
+
+            // the index has to describe the blocks that were read
+            const uint64_t indexOffset = offset + 4;
+            if (readUInt32(is) != frames.size()) throw std::runtime_error("Invalid block index");
+            for (const IndexEntry& frame : frames) {
+                if (!(readIndexEntry(is) == frame)) throw std::runtime_error("Invalid block index");
+            }
+            std::array<char, indexMagic.size()> end{};
+            if (readUInt64(is) != indexOffset || readUInt64(is) != uncompressedOffset
+                || !is.read(end.data(), end.size()) || end != indexMagic) {
+                throw std::runtime_error("Invalid block stream trailer");
+            }
+        }
+    }
+
+    // expand all blocks of a block stream whose header was already read
+    // @param verify check the checksums of framed streams, the sizes of the blocks are always checked
+    [[maybe_unused]]
+    static void expandBlocks(std::istream& is, std::ostream& os, const Header& header, const BlockCodec& expandBlock,
+                             const size_t numThreads = 1, const bool verify = true) {
+        if (header.version >= firstFramedVersion) {
+            internal::expandFramed(is, os, header, expandBlock, numThreads, verify);
+            return;
+        }
+        auto readNext = [&is](std::string& buf) {
+            uint32_t size;
+            if (!internal::readUInt32(is, size)) return false;
+            if (!internal::readBlock(is, buf, size) || buf.size() != size) {
+                throw std::runtime_error("Stream finished unexpectedly");
+            }
+            return true;
+        };
+        auto write = [&os](const std::string& expanded) {
+            STATS_COUNT(expanded);
+            STATS_STAGE(timer, "block.write", expanded.size());
+            STATS_OUTPUT(timer, expanded.size());
+            os.write(expanded.data(), static_cast<std::streamsize>(expanded.size()));
+        };
+        internal::process<std::string>(readNext, expandBlock, write, numThreads);
+    }
+
+    // read the header and the index of a framed stream that starts at the current position
+    // the stream has to be seekable, it is left at an unspecified position
+    [[maybe_unused]]
+    static Index readIndex(std::istream& is) {
+        Index index;
+        index.start = is.tellg();
+        index.header = readHeader(is);
+        if (index.header.version < firstFramedVersion) throw std::runtime_error("Stream has no block index");
+
+        is.seekg(0, std::ios::end);
+        const auto size = static_cast<uint64_t>(is.tellg() - index.start);
+        if (size < internal::headerSize + 4 + 4 + trailerSize) throw std::runtime_error("Invalid block stream trailer");
+        is.seekg(index.start + static_cast<std::streamoff>(size - trailerSize));
+        const uint64_t indexOffset = internal::readUInt64(is);
+        index.uncompressedSize = internal::readUInt64(is);
+        std::array<char, indexMagic.size()> end{};
+        if (!is.read(end.data(), end.size()) || end != indexMagic || indexOffset > size - trailerSize - 4) {
+            throw std::runtime_error("Invalid block stream trailer");
+        }
+
+        is.seekg(index.start + static_cast<std::streamoff>(indexOffset));
+        const uint32_t numBlocks = internal::readUInt32(is);
+        if (uint64_t{numBlocks} * internal::indexEntrySize != size - trailerSize - indexOffset - 4) {
+            throw std::runtime_error("Invalid block index");
+        }
+        index.entries.reserve(numBlocks);
+        uint64_t offset = internal::headerSize;
+        uint64_t uncompressedOffset = 0;
+        for (uint32_t i = 0; i < numBlocks; ++i) {
+            const IndexEntry& entry = index.entries.emplace_back(internal::readIndexEntry(is));
+            // the entries have to be in order for searching them, and their frames have to end before the index
+            if (entry.offset != offset || entry.uncompressedOffset != uncompressedOffset) {
+                throw std::runtime_error("Invalid block index");
+            }
+            internal::checkFrameSizes(index.header, entry.compressedSize, entry.uncompressedSize);
+            offset += internal::frameHeaderSize + entry.compressedSize;
+            uncompressedOffset += entry.uncompressedSize;
+        }
+        if (offset + 4 != indexOffset || uncompressedOffset != index.uncompressedSize) {
+            throw std::runtime_error("Invalid block index");
+        }
+        return index;
+    }
+
+    // expand length bytes of the uncompressed data starting at offset (both are clamped to the data)
+    // only the blocks that overlap the range are read and expanded
+    // @param index read from the same stream with readIndex
+    // @param verify check the checksums of the expanded blocks
+    [[maybe_unused]]
+    static void expandRange(std::istream& is, std::ostream& os, const Index& index, const uint64_t offset,
+                            const uint64_t length, const BlockCodec& expandBlock, const size_t numThreads = 1,
+                            const bool verify = true) {
+        const uint64_t first = std::min(offset, index.uncompressedSize);
+        const uint64_t last = first + std::min(length, index.uncompressedSize - first);
+        if (first == last) return;
+
+        // first block that ends after the start of the range
+        auto it = std::upper_bound(index.entries.begin(), index.entries.end(), first,
+                                   [](const uint64_t pos, const IndexEntry& entry) {
+                                       return pos < entry.uncompressedOffset + entry.uncompressedSize;
+                                   });
+        auto readNext = [&is, &index, &it, first, last](internal::FrameSlice& slice) {
+            if (it == index.entries.end() || it->uncompressedOffset >= last) return false;
+            const IndexEntry& entry = *it++;
+            is.clear();
+            is.seekg(index.start + static_cast<std::streamoff>(entry.offset));
+            if (internal::readUInt32(is) != entry.compressedSize || internal::readUInt32(is) != entry.uncompressedSize
+                || internal::readUInt32(is) != entry.crc) {
+                throw std::runtime_error("Block does not match the block index");
+            }
+            internal::readBlock(is, slice.frame.data, entry.compressedSize);
+            if (slice.frame.data.size() != entry.compressedSize) {
+                throw std::runtime_error("Stream finished unexpectedly");
+            }
+            slice.frame.uncompressedSize = entry.uncompressedSize;
+            slice.frame.crc = entry.crc;
+            slice.first = static_cast<size_t>(std::max(first, entry.uncompressedOffset) - entry.uncompressedOffset);
+            slice.last = static_cast<size_t>(std::min(last, entry.uncompressedOffset + entry.uncompressedSize)
+                                             - entry.uncompressedOffset);
+            return true;
+        };
+        auto expand = [&expandBlock, verify](const internal::FrameSlice& slice) {
+            return internal::expandFrame(expandBlock, slice.frame, verify).substr(slice.first, slice.last - slice.first);
+        };
+        auto write = [&os](const std::string& expanded) {
+            os.write(expanded.data(), static_cast<std::streamsize>(expanded.size()));
+        };
+        internal::process<internal::FrameSlice>(readNext, expand, write, numThreads);
+    }
+
+    // expand a block stream including its header
+    // @param expandBlock returns the function for expanding blocks of the given block stream version
+    [[maybe_unused]]
+    static void expand(std::istream& is, std::ostream& os, const std::function<BlockCodec(uint8_t)>& expandBlock,
+                       const size_t numThreads = 1, const bool verify = true) {
+        const Header header = readHeader(is);
+        if (!header) throw std::runtime_error("Input is not a block stream");
+        expandBlocks(is, os, header, expandBlock(header.version), numThreads, verify);
+    }
+} // block
+
+#endif //COMPRESSION_CPP_BLOCKSTREAM_H
@@ -3,79 +3,106 @@
 
 #include <istream>
 #include <ostream>
-#include <sstream>
-#include "BitStreamIn.h"
+#include <string>
+#include <string_view>
+#include <iterator>
+#include <limits>
+#include <stdexcept>
+#include <array>
+#include <vector>
 #include "CircularSuffix.h"
-#include "BitStreamOut.h"
+#include "Stats.h"
 
 namespace bw {
+    // apply the Burrows-Wheeler transform to a buffer
+    // @return index of the original string in the sorted rotations (32 bit, big endian) followed by the last column
     [[maybe_unused]]
-    static void encode(std::istream& is, std::ostream& os) {
-        std::basic_stringstream<uint8_t> ss;
-        uint8_t c;
-        while (is.read(reinterpret_cast<char*>(&c), 1)) {
-            ss.write(&c, 1);
+    static std::string encode(const std::string_view input) {
+        STATS_STAGE(timer, "bw", input.size());
+        const auto sv = std::basic_string_view<uint8_t>(reinterpret_cast<const uint8_t*>(input.data()), input.size());
+        std::vector<size_t> order;
+        {
+            STATS_STAGE(sortTimer, "bw.sort", input.size());
+            order = circular_suffix::sort<uint8_t>(sv);
         }
-        const std::basic_string<uint8_t> s = ss.str();
-        const auto order = circular_suffix::sort<uint8_t>(s); // this can be implemented more efficiently
-        // write index of original string in sorted suffix array
-        for (size_t i=0; i < s.size(); ++i) {
+        if (order.empty()) return {};
+
+        std::string output(4 + input.size(), '\0');
+        for (size_t i=0; i < order.size(); ++i) {
             if (order[i] == 0) {
-                BitStreamOut bso(os);
-                bso.writeInteger(i, 32);
-                break;
+                output[0] = static_cast<char>(i >> 24);
+                output[1] = static_cast<char>(i >> 16);
+                output[2] = static_cast<char>(i >> 8);
+                output[3] = static_cast<char>(i);
             }
+            const size_t indexLastCol = (order[i] == 0 ? input.size() : order[i]) - 1;
+            output[4 + i] = input[indexLastCol];
         }
-
-        for (const auto startIndex : order) {
-            const size_t indexLastCol = (startIndex + s.size() - 1) % s.size();
-            os.write(reinterpret_cast<const char*>(&s[indexLastCol]), 1);
-        }
+        STATS_OUTPUT(timer, output.size());
+        return output;
     }
 
-    [[maybe_unused]]
-    static void decode(std::istream& is, std::ostream& os) {
-        uint32_t first;
-        {   // limit scope of bsi
-            BitStreamIn bsi(is);
-            first = bsi.readInteger<uint32_t>();
-        }
-        std::basic_stringstream<uint8_t> ss;
-        {
-            uint8_t c;
-            while (is.read(reinterpret_cast<char*>(&c), 1)) {
-                ss.write(&c, 1);
+    namespace internal {
+        template<typename Index>
+        static std::string decode(const std::basic_string_view<uint8_t> sLastCol, const size_t first) {
+            // count occurrences of each char
+            constexpr size_t R = 256;
+            std::array<size_t,R+1> count{}; // offset of +1 while counting
+            for (const size_t c : sLastCol) {
+                ++count[c+1];
             }
-        }
-        const std::basic_string<uint8_t> sLastCol = ss.str();
 
-        // count occurrences of each char
-        constexpr size_t R = 256;
-        std::array<size_t,R+1> count{}; // offset of +1 while counting
-        for (const size_t c : sLastCol) {
-            ++count[c+1];
-        }
+            // accumulate count
+            for (size_t i=1; i < count.size(); ++i) {
+                count[i] += count[i-1];
+            }
 
-        // accumulate count
-        for (size_t i=1; i < count.size(); ++i) {
-            count[i] += count[i-1];
+            // determine the next index to look at for each index of the sorted string (first column of sorted
+            // suffix arrays); the character at a sorted index is the one whose bucket contains it
+            std::vector<Index> next(sLastCol.size());
+            for (size_t i=0; i < sLastCol.size(); ++i) {
+                next[count[sLastCol[i]]++] = static_cast<Index>(i);
+            }
+            std::string output(sLastCol.size(), '\0');
+            size_t index = first;
+            for (size_t i=0; i < sLastCol.size(); ++i) {
+                output[i] = static_cast<char>(sLastCol[next[index]]); // first column char == last column char of next
+                index = next[index];
+            }
+            return output;
         }
+    }
 
-        // determine sorted string (first column of sorted suffix arrays) and the next index to look at for each
-        std::vector<size_t> next(sLastCol.size());
-        std::basic_string<uint8_t> sFirstCol(sLastCol.size(), 0);
-        for (size_t i=0; i < sLastCol.size(); ++i) {
-            const size_t sortedI = count[sLastCol[i]]++; // index of sLastCol[i] after sorting
-            sFirstCol[sortedI] = sLastCol[i];
-            next[sortedI] = i;
-        }
+    // reverse the Burrows-Wheeler transform of a buffer that was created by encode
+    [[maybe_unused]]
+    static std::string decode(const std::string_view input) {
+        STATS_STAGE(timer, "bw", input.size());
+        if (input.size() < 4) throw std::runtime_error("Stream finished unexpectedly");
+        const auto bytes = reinterpret_cast<const uint8_t*>(input.data());
+        const uint32_t first = (uint32_t{bytes[0]} << 24) | (uint32_t{bytes[1]} << 16)
+                               | (uint32_t{bytes[2]} << 8) | bytes[3];
+        const auto sLastCol = std::basic_string_view<uint8_t>(bytes + 4, input.size() - 4);
+        if (first >= sLastCol.size() && !sLastCol.empty()) throw std::runtime_error("Invalid Burrows-Wheeler index");
 
-        // write result
-        size_t index = first;
-        for (size_t i=0; i < sLastCol.size(); ++i) {
-            os.write(reinterpret_cast<const char*>(&sFirstCol[index]), 1);
-            index = next[index];
-        }
+        // uint32_t indices need half the memory of size_t
+        std::string output = sLastCol.size() <= std::numeric_limits<uint32_t>::max()
+                             ? internal::decode<uint32_t>(sLastCol, first) : internal::decode<size_t>(sLastCol, first);
+        STATS_OUTPUT(timer, output.size());
+        return output;
+    }
+
+    [[maybe_unused]]
+    static void encode(std::istream& is, std::ostream& os) {
+        const std::string input(std::istreambuf_iterator<char>(is), {});
+        const std::string output = encode(input);
+        os.write(output.data(), static_cast<std::streamsize>(output.size()));
+    }
+
+    [[maybe_unused]]
+    static void decode(std::istream& is, std::ostream& os) {
+        const std::string input(std::istreambuf_iterator<char>(is), {});
+        const std::string output = decode(input);
+        os.write(output.data(), static_cast<std::streamsize>(output.size()));
     }
 } // bw
 
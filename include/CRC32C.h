@@ -0,0 +1,171 @@
+#ifndef COMPRESSION_CPP_CRC32C_H
+#define COMPRESSION_CPP_CRC32C_H
+
+#include <array>
+#include <string_view>
+#include <cstdint>
+#include <cstddef>
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#define CRC32C_X86_KERNEL 1
+#include <immintrin.h>
+#endif
+
+// CRC-32C (Castagnoli) checksums, as used by iSCSI, ext4 and SSE4.2
+namespace crc32c {
+    constexpr static uint32_t polynomial = 0x82F63B78; // reversed representation
+
+    namespace internal {
+        using Tables = std::array<std::array<uint32_t, 256>, 8>;
+
+        // tables[0] is the remainder of each byte, tables[k] the remainder of each byte followed by k zero bytes
+        constexpr Tables makeTables() {
+            Tables tables{};
+            for (uint32_t i = 0; i < 256; ++i) {
+                uint32_t crc = i;
+                for (int bit = 0; bit < 8; ++bit) {
+                    crc = (crc >> 1) ^ ((crc & 1) ? polynomial : 0);
+                }
+                tables[0][i] = crc;
+            }
+            for (size_t k = 1; k < tables.size(); ++k) {
+                for (size_t i = 0; i < 256; ++i) {
+                    tables[k][i] = (tables[k-1][i] >> 8) ^ tables[0][tables[k-1][i] & 0xFF];
+                }
+            }
+            return tables;
+        }
+
+        constexpr static Tables tables = makeTables();
+
+        // product of a and b modulo the polynomial, in the reversed representation (bit 31 is x^0)
+        constexpr uint32_t multiply(const uint32_t a, uint32_t b) {
+            uint32_t product = 0;
+            for (uint32_t bit = uint32_t{1} << 31; bit != 0; bit >>= 1) {
+                if (a & bit) product ^= b;
+                b = (b & 1) ? (b >> 1) ^ polynomial : b >> 1; // multiply b by x
+            }
+            return product;
+        }
+
+        // x^n modulo the polynomial: multiplying a checksum register by x^(8n) appends n zero bytes
+        constexpr uint32_t powerOfX(uint64_t n) {
+            uint32_t result = uint32_t{1} << 31; // x^0
+            uint32_t square = uint32_t{1} << 30; // x^1
+            for (; n > 0; n >>= 1) {
+                if (n & 1) result = multiply(result, square);
+                square = multiply(square, square);
+            }
+            return result;
+        }
+
+        // the SSE4.2 kernel processes three stripes of stripeSize bytes at once, so that the latency of the crc32
+        // instruction (3 cycles) is hidden, and combines their checksums with multiplications by stripeShift
+        constexpr static size_t stripeSize = 16 * 1024;
+        constexpr static uint32_t stripeShift = powerOfX(8 * stripeSize);
+
+        // the kernels update the raw register value crc, without the inversions at the start and end
+
+        // one table lookup per byte (reference kernel)
+        [[maybe_unused]]
+        static uint32_t extendBytewise(uint32_t crc, const uint8_t* data, const size_t size) {
+            for (size_t i = 0; i < size; ++i) {
+                crc = tables[0][(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+            }
+            return crc;
+        }
+
+        [[maybe_unused]]
+        static inline uint32_t loadLittleEndian(const uint8_t* data) {
+            return uint32_t{data[0]} | (uint32_t{data[1]} << 8) | (uint32_t{data[2]} << 16) | (uint32_t{data[3]} << 24);
+        }
+
+        // slicing-by-8: eight independent lookups per eight bytes instead of a chain of eight dependent ones
+        [[maybe_unused]]
+        static uint32_t extendSlicing8(uint32_t crc, const uint8_t* data, size_t size) {
+            for (; size >= 8; data += 8, size -= 8) {
+                const uint32_t low = crc ^ loadLittleEndian(data);
+                const uint32_t high = loadLittleEndian(data + 4);
+                crc = tables[7][low & 0xFF] ^ tables[6][(low >> 8) & 0xFF] ^ tables[5][(low >> 16) & 0xFF]
+                      ^ tables[4][low >> 24] ^ tables[3][high & 0xFF] ^ tables[2][(high >> 8) & 0xFF]
+                      ^ tables[1][(high >> 16) & 0xFF] ^ tables[0][high >> 24];
+            }
+            return extendBytewise(crc, data, size);
+        }
+
+#ifdef CRC32C_X86_KERNEL
+        // crc32 instruction of SSE4.2, which computes exactly this checksum for 8 bytes at a time
+        [[maybe_unused]] __attribute__((target("sse4.2")))
+        static uint32_t extendSSE42(uint32_t crc, const uint8_t* data, size_t size) {
+#ifdef __x86_64__
+            const auto load = [](const uint8_t* p) {
+                uint64_t word;
+                __builtin_memcpy(&word, p, 8);
+                return word;
+            };
+            for (; size >= 3 * stripeSize; data += 3 * stripeSize, size -= 3 * stripeSize) {
+                uint64_t crc0 = crc, crc1 = 0, crc2 = 0;
+                for (size_t i = 0; i < stripeSize; i += 8) {
+                    crc0 = _mm_crc32_u64(crc0, load(data + i));
+                    crc1 = _mm_crc32_u64(crc1, load(data + stripeSize + i));
+                    crc2 = _mm_crc32_u64(crc2, load(data + 2 * stripeSize + i));
+                }
+                // the checksum of stripes a and b is the one of a followed by zeros plus the one of b
+                crc = multiply(stripeShift, multiply(stripeShift, static_cast<uint32_t>(crc0))
+                                            ^ static_cast<uint32_t>(crc1)) ^ static_cast<uint32_t>(crc2);
+            }
+            uint64_t crc64 = crc;
+            for (; size >= 8; data += 8, size -= 8) {
+                crc64 = _mm_crc32_u64(crc64, load(data));
+            }
+            crc = static_cast<uint32_t>(crc64);
+#endif
+            for (; size >= 4; data += 4, size -= 4) {
+                uint32_t word;
+                __builtin_memcpy(&word, data, 4);
+                crc = _mm_crc32_u32(crc, word);
+            }
+            for (; size > 0; ++data, --size) {
+                crc = _mm_crc32_u8(crc, *data);
+            }
+            return crc;
+        }
+#endif
+
+        using Kernel = uint32_t (*)(uint32_t, const uint8_t*, size_t);
+
+        [[maybe_unused]]
+        static bool supportsSSE42() {
+#ifdef CRC32C_X86_KERNEL
+            return __builtin_cpu_supports("sse4.2");
+#else
+            return false;
+#endif
+        }
+
+        // fastest kernel supported by the CPU
+        [[maybe_unused]]
+        static Kernel kernel() {
+#ifdef CRC32C_X86_KERNEL
+            static const Kernel kernel = supportsSSE42() ? extendSSE42 : extendSlicing8;
+            return kernel;
+#else
+            return extendSlicing8;
+#endif
+        }
+    }
+
+    // checksum of the concatenation of the data with checksum crc and data
+    [[maybe_unused]]
+    static uint32_t extend(const uint32_t crc, const std::string_view data) {
+        return ~internal::kernel()(~crc, reinterpret_cast<const uint8_t*>(data.data()), data.size());
+    }
+
+    // checksum of data
+    [[maybe_unused]]
+    static uint32_t compute(const std::string_view data) {
+        return extend(0, data);
+    }
+} // crc32c
+
+#endif //COMPRESSION_CPP_CRC32C_H
@@ -2,14 +2,183 @@
 #define COMPRESSION_CPP_CIRCULARSUFFIX_H
 
 #include <numeric>
+#include <vector>
+#include <string_view>
+#include <algorithm>
+#include <limits>
+#include <cstdint>
+#include <type_traits>
 
 namespace circular_suffix {
-    // sort the circular suffixes starting at each index of the input string
-    // NOTE: this implementation is not very efficient! O(n^2*log(n)) in the worst case
+    namespace internal {
+        // view of the input string doubled and terminated by a unique, smallest sentinel (0), with all other
+        // characters shifted by +1. Suffix i < n of this text starts with rotation i of the input.
+        template<typename CharType>
+        class DoubledText {
+        public:
+            explicit DoubledText(const std::basic_string_view<CharType> sv) : sv{sv} {}
+
+            [[nodiscard]]
+            size_t operator[](const size_t i) const {
+                if (i >= 2*sv.size()) return 0; // sentinel
+                const size_t idx = i < sv.size() ? i : i - sv.size();
+                return static_cast<size_t>(static_cast<std::make_unsigned_t<CharType>>(sv[idx])) + 1;
+            }
+        private:
+            const std::basic_string_view<CharType> sv;
+        };
+
+        // compute start (or end) of each bucket of characters in s
+        template<typename Index, typename Text>
+        static void getBuckets(const Text& s, const Index n, std::vector<Index>& bkt, const bool end) {
+            std::fill(bkt.begin(), bkt.end(), 0);
+            for (Index i = 0; i < n; ++i) {
+                ++bkt[s[i]];
+            }
+            Index sum = 0;
+            for (auto& b : bkt) {
+                sum += b;
+                b = end ? sum : sum - b;
+            }
+        }
+
+        // SA-IS suffix array construction (Nong, Zhang & Chan) in O(n)
+        // s has to end with a unique sentinel 0, all other values have to be in [1, K)
+        template<typename Index, typename Text>
+        static void sais(const Text& s, Index* sa, const Index n, const Index K) {
+            constexpr Index EMPTY = std::numeric_limits<Index>::max();
+            if (n == 1) {
+                sa[0] = 0;
+                return;
+            }
+
+            // classify suffixes as S-type (true) or L-type (false)
+            std::vector<bool> t(n);
+            t[n-1] = true;
+            for (Index i = n-1; i-- > 0;) {
+                t[i] = s[i] < s[i+1] || (s[i] == s[i+1] && t[i+1]);
+            }
+            auto isLMS = [&t](const Index i) {
+                return i > 0 && i != EMPTY && t[i] && !t[i-1];
+            };
+
+            std::vector<Index> bkt(K);
+            auto induce = [&]() {
+                // induce L-type suffixes from the left
+                getBuckets(s, n, bkt, false);
+                for (Index i = 0; i < n; ++i) {
+                    const Index j = sa[i];
+                    if (j != EMPTY && j > 0 && !t[j-1]) sa[bkt[s[j-1]]++] = j-1;
+                }
+                // induce S-type suffixes from the right
+                getBuckets(s, n, bkt, true);
+                for (Index i = n; i-- > 0;) {
+                    const Index j = sa[i];
+                    if (j != EMPTY && j > 0 && t[j-1]) sa[--bkt[s[j-1]]] = j-1;
+                }
+            };
+
+            // stage 1: sort LMS substrings by placing them at the ends of their buckets and inducing
+            getBuckets(s, n, bkt, true);
+            std::fill(sa, sa+n, EMPTY);
+            for (Index i = 1; i < n; ++i) {
+                if (isLMS(i)) sa[--bkt[s[i]]] = i;
+            }
+            induce();
+
+            // move all sorted LMS substrings to the front
+            Index n1 = 0;
+            for (Index i = 0; i < n; ++i) {
+                if (isLMS(sa[i])) sa[n1++] = sa[i];
+            }
+
+            // name the LMS substrings, equal substrings get the same name
+            std::fill(sa+n1, sa+n, EMPTY);
+            Index name = 0;
+            Index prev = EMPTY;
+            for (Index i = 0; i < n1; ++i) {
+                const Index pos = sa[i];
+                bool diff = false;
+                for (Index d = 0; d < n; ++d) {
+                    if (prev == EMPTY || s[pos+d] != s[prev+d] || t[pos+d] != t[prev+d]) {
+                        diff = true;
+                        break;
+                    } else if (d > 0 && (isLMS(pos+d) || isLMS(prev+d))) {
+                        break;
+                    }
+                }
+                if (diff) {
+                    ++name;
+                    prev = pos;
+                }
+                sa[n1 + pos/2] = name - 1;
+            }
+            for (Index i = n, j = n; i-- > n1;) {
+                if (sa[i] != EMPTY) sa[--j] = sa[i];
+            }
+
+            // stage 2: sort the reduced string, recursing if names are not unique yet
+            Index* s1 = sa + n - n1;
+            Index* sa1 = sa;
+            if (name < n1) {
+                sais<Index, const Index*>(s1, sa1, n1, name);
+            } else {
+                for (Index i = 0; i < n1; ++i) sa1[s1[i]] = i;
+            }
+
+            // stage 3: induce the final suffix array from the sorted LMS suffixes
+            getBuckets(s, n, bkt, true);
+            for (Index i = 1, j = 0; i < n; ++i) {
+                if (isLMS(i)) s1[j++] = i; // s1 is reused for the positions of LMS suffixes
+            }
+            for (Index i = 0; i < n1; ++i) {
+                sa1[i] = s1[sa1[i]];
+            }
+            std::fill(sa+n1, sa+n, EMPTY);
+            for (Index i = n1; i-- > 0;) {
+                const Index j = sa[i];
+                sa[i] = EMPTY;
+                sa[--bkt[s[j]]] = j;
+            }
+            induce();
+        }
+
+        template<typename Index, typename CharType>
+        static std::vector<size_t> sort(const std::basic_string_view<CharType> sv) {
+            constexpr Index K = Index{1} << (8*sizeof(CharType)); // +1 for sentinel is added below
+            const DoubledText<CharType> text(sv);
+            const Index n = 2*sv.size() + 1;
+            std::vector<Index> sa(n);
+            sais<Index>(text, sa.data(), n, K + 1);
+
+            // suffixes starting in the first half are the sorted rotations
+            std::vector<size_t> order;
+            order.reserve(sv.size());
+            for (const Index pos : sa) {
+                if (pos < sv.size()) order.push_back(pos);
+            }
+            return order;
+        }
+    } // internal
+
+    // sort the circular suffixes starting at each index of the input string in O(n) with SA-IS
+    // rotations that are equal (only possible for periodic input) may be returned in any order
     // @return vector of starting positions of sorted suffix array, i.e. if input is "abcd" then 0 represents "abcd",
     //         1, represents "bcda", etc.
     template<typename CharType>
     static std::vector<size_t> sort(const std::basic_string_view<CharType> sv) {
+        static_assert(sizeof(CharType) == 1, "Only byte-sized characters are supported");
+        if (sv.empty()) return {};
+        if (2*sv.size() + 1 < std::numeric_limits<uint32_t>::max()) {
+            return internal::sort<uint32_t>(sv); // half the memory of size_t
+        }
+        return internal::sort<size_t>(sv);
+    }
+
+    // reference implementation of sort by directly comparing the rotations (used in unit tests)
+    // NOTE: this implementation is not very efficient! O(n^2*log(n)) in the worst case
+    template<typename CharType>
+    static std::vector<size_t> sortNaive(const std::basic_string_view<CharType> sv) {
         std::vector<size_t> order(sv.size());
         std::iota(order.begin(), order.end(), 0); // fill with index
 
@@ -2,28 +2,51 @@
 #define STRING_PROCESSING_CPP_HUFFMAN_H
 
 #include <memory>
+#include <optional>
+#include <array>
+#include <vector>
+#include <algorithm>
+#include <numeric>
+#include <cstdlib>
+#include <iterator>
+#include <limits>
+#include <string_view>
 #include <queue>
 #include <functional>
 #include <sstream>
 #include <iostream>
-#include "PriorityQueueExtended.h" // priority_queue which works with unique_ptr
 #include "ShortBitSet.h"
 #include "BitStreamOut.h"
 #include "BitStreamIn.h"
+#include "MemoryStreamBuf.h"
+#include "NodePool.h"
+#include "Stats.h"
 
 namespace huffman {
 
-    class Node;
-    using NodePtr = std::unique_ptr<Node>;
-
     const int R = 256; // extended ASCII radix
     using TrieTable = std::array<ShortBitSet, R>;
+    using CodeLengths = std::array<uint8_t, R>; // length of the code of each character, 0 if it does not occur
+    // largest input of a single Huffman block, the occurrences of each character are counted as int
+    constexpr static size_t maxInputSize = static_cast<size_t>(std::numeric_limits<int>::max());
+    constexpr static size_t maxCodeLength = 15; // default maximum length of codes, keeps decoding tables small
+    constexpr static size_t maxNumTables = 6; // code tables of the multi-table format
+    constexpr static size_t selectorGroupSize = 50; // symbols coded with the same table in the multi-table format
+    constexpr static size_t numRefinements = 4; // iterations for improving the tables of the multi-table format
+
+    // Format of the compressed data, which is not recorded in it: the public functions default to Trie, the format of
+    // data written before Canonical existed, block streams record it with their version and use Canonical
+    enum class Format : uint8_t {
+        Trie, // serialized trie, followed by 32 bit length and codes
+        Canonical, // code lengths of canonical codes, followed by 32 bit length and codes
+    };
 
     // A node in the trie, representing a single character (leaf) or sub-trie
+    // the children are owned by the pool of the trie
     class Node {
     public:
-        explicit Node(char ch, int freq, NodePtr left, NodePtr right) :
-                m_ch{ch}, m_freq{freq}, m_left{std::move(left)}, m_right{std::move(right)} {}
+        explicit Node(char ch, int freq, Node *left, Node *right) :
+                m_ch{ch}, m_freq{freq}, m_left{left}, m_right{right} {}
 
         [[nodiscard]]
         bool isLeaf() const {
@@ -37,27 +60,48 @@ namespace huffman {
         int freq() const { return m_freq; }
 
         [[nodiscard]]
-        Node *left() const { return m_left.get(); }
+        Node *left() const { return m_left; }
 
         [[nodiscard]]
-        Node *right() const { return m_right.get(); }
+        Node *right() const { return m_right; }
 
     private:
         char m_ch;
         int m_freq;
-        NodePtr m_left;
-        NodePtr m_right;
+        Node *m_left;
+        Node *m_right;
     };
 
-    // Comparison operator (to be able to use NodePtr in priority queue)
-    [[maybe_unused]]
-    bool operator>(const NodePtr &lhs, const NodePtr &rhs) {
-        return lhs->freq() > rhs->freq();
-    }
+    // A trie whose nodes are allocated from its own pool: building it needs a single allocation for the nodes and
+    // they are all released at once with the trie
+    class Trie {
+    public:
+        Trie() : pool(2 * R - 1) {} // number of nodes of a full trie
+
+        // create a node that belongs to this trie
+        Node *newNode(char ch, int freq, Node *left, Node *right) {
+            return pool.create(ch, freq, left, right);
+        }
+
+        void setRoot(Node *root) { m_root = root; }
+
+        [[nodiscard]]
+        const Node *root() const { return m_root; }
+
+        explicit operator bool() const { return m_root != nullptr; }
+
+        const Node &operator*() const { return *m_root; }
+
+        const Node *operator->() const { return m_root; }
+
+    private:
+        NodePool<Node> pool;
+        Node *m_root = nullptr;
+    };
 
     // check (sub-)tries for equality (used in unit tests)
     [[maybe_unused]]
-    bool operator==(const Node &lhs, const Node &rhs) {
+    inline bool operator==(const Node &lhs, const Node &rhs) {
         if (&lhs == &rhs) return true;
         if (lhs.isLeaf() != rhs.isLeaf()) return false;
         if (lhs.isLeaf()) {
@@ -73,34 +117,153 @@ namespace huffman {
     }
 
     namespace internal {
+        // assign canonical codes: shorter codes first, codes of the same length in order of the characters
+        // a single character with length 0 gets an empty code
+        template<size_t N>
+        static std::array<ShortBitSet, N> canonicalCodes(const std::array<uint8_t, N> &lengths) {
+            std::vector<uint16_t> symbols;
+            for (size_t c = 0; c < lengths.size(); ++c) {
+                if (lengths[c] > ShortBitSet::max_size) throw std::runtime_error("Invalid code length");
+                if (lengths[c] > 0) symbols.push_back(static_cast<uint16_t>(c));
+            }
+            std::stable_sort(symbols.begin(), symbols.end(), [&lengths](const uint16_t lhs, const uint16_t rhs) {
+                return lengths[lhs] < lengths[rhs];
+            });
+
+            std::array<ShortBitSet, N> table{};
+            uint64_t code = 0;
+            uint8_t prevLength = 0;
+            for (const uint16_t c : symbols) {
+                code <<= lengths[c] - prevLength;
+                prevLength = lengths[c];
+                if (code >> lengths[c]) throw std::runtime_error("Invalid code lengths"); // too many short codes
+                for (size_t i = lengths[c]; i-- > 0;) {
+                    table[c].push_back((code >> i) & 1);
+                }
+                ++code;
+            }
+            return table;
+        }
+
+        // determine optimal code lengths of at most maxLength bits with the package-merge algorithm
+        template<size_t N>
+        static std::array<uint8_t, N> packageMerge(const std::array<int, N> &frequencies, const size_t maxLength) {
+            // an item is a leaf (a single character) or a package of two items of the previous level
+            struct Item {
+                uint64_t weight;
+                int symbol; // -1 for packages
+                size_t left, right; // indices of the packaged items
+            };
+            std::vector<Item> items;
+            std::vector<size_t> leaves;
+            for (int i = 0; i < static_cast<int>(N); ++i) {
+                if (frequencies[i] > 0) {
+                    leaves.push_back(items.size());
+                    items.push_back({static_cast<uint64_t>(frequencies[i]), i, 0, 0});
+                }
+            }
+            std::stable_sort(leaves.begin(), leaves.end(), [&items](const size_t lhs, const size_t rhs) {
+                return items[lhs].weight < items[rhs].weight;
+            });
+
+            std::array<uint8_t, N> lengths{};
+            if (leaves.size() <= 1) {
+                for (const size_t leaf : leaves) lengths[items[leaf].symbol] = 1;
+                return lengths;
+            }
+            if (maxLength > ShortBitSet::max_size || (uint64_t{1} << maxLength) < leaves.size()) {
+                throw std::invalid_argument("Maximum code length is too short or too long for input");
+            }
+
+            std::vector<size_t> list = leaves;
+            for (size_t level = 1; level < maxLength; ++level) {
+                // package pairs of items of the previous level and merge them with the leaves
+                std::vector<size_t> packages;
+                for (size_t i = 0; i + 1 < list.size(); i += 2) {
+                    packages.push_back(items.size());
+                    items.push_back({items[list[i]].weight + items[list[i+1]].weight, -1, list[i], list[i+1]});
+                }
+                list.clear();
+                std::merge(leaves.begin(), leaves.end(), packages.begin(), packages.end(), std::back_inserter(list),
+                           [&items](const size_t lhs, const size_t rhs) { return items[lhs].weight < items[rhs].weight; });
+            }
+
+            // the code length of each character is the number of selected items that contain it
+            std::vector<size_t> stack(list.begin(), list.begin() + static_cast<std::ptrdiff_t>(2 * leaves.size() - 2));
+            while (!stack.empty()) {
+                const Item &item = items[stack.back()];
+                stack.pop_back();
+                if (item.symbol >= 0) {
+                    ++lengths[item.symbol];
+                } else {
+                    stack.push_back(item.left);
+                    stack.push_back(item.right);
+                }
+            }
+            return lengths;
+        }
+
+        // build a trie with the canonical codes for the given code lengths
+        [[maybe_unused]]
+        static Trie trieFromLengths(const CodeLengths &lengths) {
+            const TrieTable table = canonicalCodes(lengths);
+            Trie trie;
+            // insert the codes one after another, creating inner nodes on the way
+            std::function<Node*(size_t, uint32_t)> build = [&](const size_t depth, const uint32_t prefix) -> Node* {
+                for (size_t c = 0; c < R; ++c) {
+                    if (lengths[c] > 0 && lengths[c] == depth && table[c].value() == prefix) {
+                        return trie.newNode(static_cast<char>(c), 0, nullptr, nullptr);
+                    }
+                }
+                if (depth >= ShortBitSet::max_size) throw std::runtime_error("Invalid code lengths");
+                Node *left = build(depth + 1, prefix << 1);
+                return trie.newNode('\0', 0, left, build(depth + 1, (prefix << 1) | 1));
+            };
+            trie.setRoot(build(0, 0));
+            return trie;
+        }
+
+        // depth of the deepest leaf
+        [[maybe_unused]]
+        static size_t depth(const Node &node) {
+            if (node.isLeaf()) return 0;
+            return 1 + std::max(depth(*node.left()), depth(*node.right()));
+        }
+
         // Build a trie using the number of occurrences of each character
+        // If the optimal trie is deeper than maxLength, a trie for optimal length-limited codes is built instead
         [[maybe_unused]]
-        static NodePtr buildTrie(const std::array<int, R> &frequencies) {
-            priority_queue<NodePtr, std::vector<NodePtr>, std::greater<>> minPQ;
+        static Trie buildTrie(const std::array<int, R> &frequencies, const size_t maxLength = maxCodeLength) {
+            Trie trie;
+            auto greaterFreq = [](const Node *lhs, const Node *rhs) { return lhs->freq() > rhs->freq(); };
+            std::priority_queue<Node*, std::vector<Node*>, decltype(greaterFreq)> minPQ(greaterFreq);
 
             // Create nodes for all characters
             for (int i = 0; i < R; ++i) {
                 const char c = static_cast<char>(i);
                 if (frequencies[i] > 0) {
-                    minPQ.push(std::make_unique<Node>(c, frequencies[i], NodePtr{}, NodePtr{}));
+                    minPQ.push(trie.newNode(c, frequencies[i], nullptr, nullptr));
                 }
             }
 
             // repeatedly combine the two least occurring subtrees
             while (minPQ.size() > 1) {
-                NodePtr left = minPQ.pop_top();
-                NodePtr right = minPQ.pop_top();
-
-                NodePtr parent = std::make_unique<Node>('\0', left->freq() + right->freq(), std::move(left),
-                                                        std::move(right));
-                minPQ.push(std::move(parent));
+                Node *left = minPQ.top();
+                minPQ.pop();
+                Node *right = minPQ.top();
+                minPQ.pop();
+                minPQ.push(trie.newNode('\0', left->freq() + right->freq(), left, right));
             }
 
             if (minPQ.empty()) {
                 // no values found in input
-                return {};
+                return trie;
             }
-            return minPQ.pop_top(); // return root
+            trie.setRoot(minPQ.top());
+            if (depth(*trie) > maxLength) {
+                return trieFromLengths(packageMerge(frequencies, maxLength));
+            }
+            return trie;
         }
 
         [[maybe_unused]]
@@ -171,17 +334,25 @@ namespace huffman {
         }
 
 
-        // convert bit input stream to trie
+        // convert bit input stream to the nodes of a sub-trie
         [[maybe_unused]]
-        static NodePtr readTrie(BitStreamIn &bsi) {
+        static Node *readTrie(BitStreamIn &bsi, Trie &trie) {
             if (bsi.readBool()) {
                 // a leaf follows
                 char c = bsi.readInteger<char>(8);
-                return std::make_unique<Node>(c, 0, NodePtr{}, NodePtr{});
+                return trie.newNode(c, 0, nullptr, nullptr);
             }
-            NodePtr x = readTrie(bsi);
-            NodePtr y = readTrie(bsi);
-            return std::make_unique<Node>('\0', 0, std::move(x), std::move(y));
+            Node *x = readTrie(bsi, trie);
+            Node *y = readTrie(bsi, trie);
+            return trie.newNode('\0', 0, x, y);
+        }
+
+        // convert bit input stream to trie
+        [[maybe_unused]]
+        static Trie readTrie(BitStreamIn &bsi) {
+            Trie trie;
+            trie.setRoot(readTrie(bsi, trie));
+            return trie;
         }
 
         // write trie to output bit stream
@@ -216,7 +387,7 @@ namespace huffman {
     // build a trie for the data in input stream
     // @param readBytes optionally return the number of bytes read from input stream
     [[maybe_unused]]
-    static NodePtr buildTrie(std::istream &is, std::optional<std::reference_wrapper<uint32_t>> readBytes = {}) {
+    static Trie buildTrie(std::istream &is, std::optional<std::reference_wrapper<uint32_t>> readBytes = {}) {
         std::array<int, R> freq{};
         uint8_t c;
         uint32_t numReadBytes = 0;
@@ -232,47 +403,299 @@ namespace huffman {
 
     // build a trie for the data in string_view
     [[maybe_unused]]
-    static NodePtr buildTrie(std::string_view sv) {
+    static Trie buildTrie(std::string_view sv) {
         std::array<int, R> freq{};
-        for(char c : sv) {
-            ++freq[c];
+        for(const char c : sv) {
+            ++freq[static_cast<uint8_t>(c)];
         }
         return internal::buildTrie(freq);
     }
 
     namespace internal {
-        // decompress input bit stream to output bit stream
-        [[maybe_unused]]
-        static void expand(BitStreamIn &input, BitStreamOut &output) {
-            const NodePtr root = internal::readTrie(input);
+        // Lookup table for decoding several bits at once instead of walking the trie bit by bit
+        // Codes of up to primaryBits bits are resolved with one lookup in the primary table, which also decodes a
+        // second symbol if its code fits into the remaining bits. Longer codes are resolved with one additional
+        // lookup in a secondary table for their first primaryBits bits.
+        class DecodeTable {
+        public:
+            constexpr static size_t primaryBits = 11;
 
-            const auto N = input.readInteger<uint32_t>();
-            for (size_t i = 0; i < N; ++i) {
-                const Node *node = root.get();
-                while (!node->isLeaf()) {
-                    if (!input.readBool()) {
-                        node = node->left();
+            template<size_t N>
+            explicit DecodeTable(const std::array<ShortBitSet, N> &codes) {
+                entries.resize(size_t{1} << primaryBits);
+
+                // fill primary table with all codes that fit, remember the longest code for each long prefix
+                std::vector<uint8_t> maxLength(entries.size(), 0);
+                for (size_t c = 0; c < codes.size(); ++c) {
+                    const size_t len = codes[c].size();
+                    if (len > primaryBits) {
+                        const size_t prefix = codes[c].value() >> (len - primaryBits);
+                        maxLength[prefix] = std::max(maxLength[prefix], static_cast<uint8_t>(len));
+                    } else if (len > 0) {
+                        const size_t first = size_t{codes[c].value()} << (primaryBits - len);
+                        for (size_t i = first; i < first + (size_t{1} << (primaryBits - len)); ++i) {
+                            entries[i] = {static_cast<uint16_t>(c), 0, static_cast<uint8_t>(len),
+                                          static_cast<uint8_t>(len), 1, 0};
+                        }
+                    }
+                }
+
+                // allocate secondary tables behind the primary one
+                for (size_t prefix = 0; prefix < maxLength.size(); ++prefix) {
+                    if (maxLength[prefix] == 0) continue;
+                    const auto subBits = static_cast<uint8_t>(maxLength[prefix] - primaryBits);
+                    entries[prefix] = {0, 0, 0, subBits, 0, static_cast<uint32_t>(entries.size())};
+                    entries.resize(entries.size() + (size_t{1} << subBits));
+                }
+                for (size_t c = 0; c < codes.size(); ++c) {
+                    const size_t len = codes[c].size();
+                    if (len <= primaryBits) continue;
+                    const Entry &primary = entries[codes[c].value() >> (len - primaryBits)];
+                    const size_t subLen = len - primaryBits;
+                    const size_t suffix = codes[c].value() & ((size_t{1} << subLen) - 1);
+                    const size_t first = primary.offset + (suffix << (primary.numBits - subLen));
+                    for (size_t i = first; i < first + (size_t{1} << (primary.numBits - subLen)); ++i) {
+                        entries[i] = {static_cast<uint16_t>(c), 0, static_cast<uint8_t>(subLen),
+                                      static_cast<uint8_t>(subLen), 1, 0};
+                    }
+                }
+
+                // combine two short codes into one primary entry where possible
+                for (size_t i = 0; i < (size_t{1} << primaryBits); ++i) {
+                    Entry &entry = entries[i];
+                    if (entry.numSymbols != 1 || entry.firstBits == 0) continue;
+                    const size_t next = (i << entry.firstBits) & ((size_t{1} << primaryBits) - 1);
+                    const Entry &second = entries[next];
+                    if (second.numSymbols >= 1 && second.firstBits > 0
+                        && entry.firstBits + second.firstBits <= primaryBits) {
+                        entry.second = second.first;
+                        entry.numBits = entry.firstBits + second.firstBits;
+                        entry.numSymbols = 2;
+                    }
+                }
+            }
+
+            // decode numSymbols symbols from input into output
+            // @param write called with each decoded symbol (uint16_t, so alphabets may have more than R symbols)
+            template<typename Write>
+            void decode(BitStreamIn &input, Write write, const size_t numSymbols) const {
+                size_t i = 0;
+                while (i < numSymbols) {
+                    const Entry &entry = entries[input.peekBits(primaryBits)];
+                    if (entry.numSymbols == 2 && i + 1 < numSymbols) {
+                        input.consumeBits(entry.numBits);
+                        write(entry.first);
+                        write(entry.second);
+                        i += 2;
+                    } else if (entry.numSymbols > 0) {
+                        input.consumeBits(entry.firstBits);
+                        write(entry.first);
+                        ++i;
+                    } else if (entry.offset > 0) {
+                        // long code
+                        input.consumeBits(primaryBits);
+                        const Entry &sub = entries[entry.offset + input.peekBits(entry.numBits)];
+                        if (sub.numSymbols == 0) throw std::runtime_error("Invalid code in input");
+                        input.consumeBits(sub.firstBits);
+                        write(sub.first);
+                        ++i;
                     } else {
-                        node = node->right();
+                        throw std::runtime_error("Invalid code in input");
                     }
                 }
-                output.writeInteger<char>(node->ch());
             }
+
+        private:
+            struct Entry {
+                uint16_t first; // first decoded symbol
+                uint16_t second; // second decoded symbol if numSymbols == 2
+                uint8_t firstBits; // length of the code of the first symbol
+                uint8_t numBits; // length of both codes, or number of bits of the secondary table if numSymbols == 0
+                uint8_t numSymbols; // 0 for invalid codes and codes that need the secondary table at offset
+                uint32_t offset;
+            };
+            std::vector<Entry> entries{}; // primary table followed by all secondary tables
+        };
+
+        // determine the length of the code of each character in the trie
+        // a trie with a single character gets length 1 so that it can be distinguished from an empty trie
+        [[maybe_unused]]
+        static CodeLengths codeLengths(const Node &root) {
+            if (root.isLeaf()) {
+                CodeLengths lengths{};
+                lengths[static_cast<uint8_t>(root.ch())] = 1;
+                return lengths;
+            }
+            CodeLengths lengths{};
+            std::vector<std::pair<const Node*, uint8_t>> stack{{&root, 0}};
+            while (!stack.empty()) {
+                const auto [x, d] = stack.back();
+                stack.pop_back();
+                if (x->isLeaf()) {
+                    lengths[static_cast<uint8_t>(x->ch())] = d;
+                } else {
+                    stack.emplace_back(x->left(), d + 1);
+                    stack.emplace_back(x->right(), d + 1);
+                }
+            }
+            return lengths;
         }
 
-        // compress inputSize bytes of input into output using an already generated trie
+        // determine code lengths of at most maxLength bits for the given number of occurrences of each character
         [[maybe_unused]]
-        static void compress(std::istream &input, const uint32_t inputSize, BitStreamOut &output, const Node &trieRoot) {
-            internal::writeTrie(output, trieRoot);
-            output.writeInteger(inputSize);
-            const TrieTable table = internal::trie2table(trieRoot);
+        static CodeLengths codeLengths(const std::array<int, R> &frequencies, const size_t maxLength = maxCodeLength) {
+            const Trie root = buildTrie(frequencies, maxLength);
+            if (!root) return {};
+            return codeLengths(*root);
+        }
+
+        // write a bit map of the used groups of 16 symbols, then a bit map of the used symbols in each used group
+        // alphabets of N > R symbols have one group per started 16 symbols, the last one may be partial
+        template<size_t N>
+        static void writeUsedSymbols(BitStreamOut &bso, const std::array<bool, N> &used) {
+            constexpr size_t groupSize = 16;
+            constexpr size_t numGroups = (N + groupSize - 1) / groupSize;
+            static_assert(numGroups <= 32, "Bit map of used groups has to fit into 32 bits");
+            auto groupEnd = [](const size_t group) { return std::min((group + 1) * groupSize, N); };
+            auto groupUsed = [&used, &groupEnd](const size_t group) {
+                return std::any_of(used.begin() + group * groupSize, used.begin() + groupEnd(group),
+                                   [](const bool u) { return u; });
+            };
+
+            for (size_t group = 0; group < numGroups; ++group) {
+                bso.write(groupUsed(group));
+            }
+            for (size_t group = 0; group < numGroups; ++group) {
+                if (!groupUsed(group)) continue;
+                for (size_t c = group * groupSize; c < groupEnd(group); ++c) {
+                    bso.write(used[c]);
+                }
+            }
+        }
+
+        // write the lengths of the used symbols: the first length (6 bits), then each length as delta to the
+        // previous one ("10": +1, "11": -1, "0": next symbol)
+        template<size_t N>
+        static void writeLengthDeltas(BitStreamOut &bso, const std::array<uint8_t, N> &lengths) {
+            bool first = true;
+            int prevLength = 0;
+            for (const uint8_t len : lengths) {
+                if (len == 0) continue;
+                if (first) {
+                    bso.writeInteger(len, 6);
+                    first = false;
+                } else {
+                    for (; prevLength < len; ++prevLength) bso.writeBits(0b10, 2);
+                    for (; prevLength > len; --prevLength) bso.writeBits(0b11, 2);
+                }
+                bso.writeBits(0, 1);
+                prevLength = len;
+            }
+        }
 
+        // write code lengths: the used characters followed by their lengths
+        template<size_t N>
+        static void writeCodeLengths(BitStreamOut &bso, const std::array<uint8_t, N> &lengths) {
+            std::array<bool, N> used{};
+            for (size_t c = 0; c < N; ++c) used[c] = lengths[c] > 0;
+            writeUsedSymbols(bso, used);
+            writeLengthDeltas(bso, lengths);
+        }
+
+        // read the used symbols written with writeUsedSymbols
+        template<size_t N>
+        static std::vector<uint16_t> readUsedSymbols(BitStreamIn &bsi) {
+            constexpr size_t groupSize = 16;
+            constexpr size_t numGroups = (N + groupSize - 1) / groupSize;
+            const uint32_t groupsUsed = bsi.readBits(numGroups);
+            std::vector<uint16_t> symbols;
+            for (size_t group = 0; group < numGroups; ++group) {
+                if (!((groupsUsed >> (numGroups - 1 - group)) & 1)) continue;
+                const size_t size = std::min(groupSize, N - group * groupSize);
+                const uint32_t used = bsi.readBits(size);
+                for (size_t i = 0; i < size; ++i) {
+                    if ((used >> (size - 1 - i)) & 1) symbols.push_back(static_cast<uint16_t>(group * groupSize + i));
+                }
+            }
+            return symbols;
+        }
+
+        // read the lengths of the given used symbols written with writeLengthDeltas
+        template<size_t N>
+        static std::array<uint8_t, N> readLengthDeltas(BitStreamIn &bsi, const std::vector<uint16_t> &symbols) {
+            std::array<uint8_t, N> lengths{};
+            int len = symbols.empty() ? 0 : static_cast<int>(bsi.readBits(6));
+            for (const uint16_t c : symbols) {
+                while (bsi.readBits(1)) {
+                    len += bsi.readBits(1) ? -1 : 1;
+                }
+                if (len < 1 || len > static_cast<int>(ShortBitSet::max_size)) {
+                    throw std::runtime_error("Invalid code length");
+                }
+                lengths[c] = static_cast<uint8_t>(len);
+            }
+            return lengths;
+        }
+
+        // read code lengths written with writeCodeLengths
+        template<size_t N = R>
+        static std::array<uint8_t, N> readCodeLengths(BitStreamIn &bsi) {
+            return readLengthDeltas<N>(bsi, readUsedSymbols<N>(bsi));
+        }
+
+        // decompress input bit stream, calling write with each decoded character
+        // @param writeRepeated called with a character and its number of repetitions instead if it is the only one
+        // @param reserve called with the number of characters from the header before write is called
+        template<typename Write, typename WriteRepeated, typename Reserve>
+        static void expand(BitStreamIn &input, Write write, WriteRepeated writeRepeated, Reserve reserve,
+                           const Format format) {
+            TrieTable codes;
+            std::optional<uint8_t> single; // only one distinct character, which is encoded with 0 bits
+            if (format == Format::Trie) {
+                const Trie root = internal::readTrie(input);
+                if (root->isLeaf()) single = static_cast<uint8_t>(root->ch());
+                codes = internal::trie2table(*root);
+            } else {
+                const CodeLengths lengths = internal::readCodeLengths(input);
+                if (std::count(lengths.begin(), lengths.end(), 0) == R - 1) {
+                    single = static_cast<uint8_t>(std::find_if(lengths.begin(), lengths.end(),
+                                                               [](const uint8_t len) { return len > 0; })
+                                                  - lengths.begin());
+                }
+                if (!single) codes = internal::canonicalCodes(lengths);
+            }
+
+            const auto N = input.readInteger<uint32_t>();
+            if (single) {
+                writeRepeated(*single, N);
+                return;
+            }
+
+            reserve(N);
+            const DecodeTable table(codes);
+            table.decode(input, write, N);
+        }
+
+        // decompress input bit stream to output bit stream
+        [[maybe_unused]]
+        static void expand(BitStreamIn &input, BitStreamOut &output, const Format format = Format::Canonical) {
+            expand(input, [&output](const uint8_t c) { output.writeInteger(c); },
+                   [&output](const uint8_t c, const size_t n) {
+                       for (size_t i = 0; i < n; ++i) output.writeInteger(c);
+                   }, [](size_t) {}, format);
+        }
+
+        // write inputSize bytes of input as codes from table
+        // @param hasCode whether a character may occur in input (only needed as a single character has an empty code)
+        [[maybe_unused]]
+        static void encode(std::istream &input, const uint32_t inputSize, BitStreamOut &output, const TrieTable &table,
+                           const std::array<bool, R> &hasCode) {
             for (size_t i = 0; i < inputSize; ++i) {
                 uint8_t c;
                 if (!input.read(reinterpret_cast<char*>(&c), 1)) {
                     throw std::runtime_error("Input ended unexpectedly");
                 }
-                if (table[c].empty()) {
+                if (!hasCode[c]) {
                     throw std::runtime_error("No code for input char found in trie");
                 }
                 output.write(table[c]);
@@ -280,63 +703,522 @@ namespace huffman {
             output.flush();
         }
 
+        // write the header of the trie format and return the code table
+        // @param hasCode set to whether a character may occur in the input
+        [[maybe_unused]]
+        static TrieTable writeHeader(BitStreamOut &output, const uint32_t inputSize, const Node &trieRoot,
+                                     std::array<bool, R> &hasCode) {
+            internal::writeTrie(output, trieRoot);
+            output.writeInteger(inputSize);
+            TrieTable table = internal::trie2table(trieRoot);
+
+            for (size_t c = 0; c < R; ++c) {
+                // only the single character of a trie which is a leaf has an empty code
+                hasCode[c] = !table[c].empty() || (trieRoot.isLeaf() && static_cast<uint8_t>(trieRoot.ch()) == c);
+            }
+            return table;
+        }
+
+        // write the header of the canonical format and return the code table
+        // @param hasCode set to whether a character may occur in the input
+        [[maybe_unused]]
+        static TrieTable writeHeader(BitStreamOut &output, const uint32_t inputSize, const CodeLengths &lengths,
+                                     std::array<bool, R> &hasCode) {
+            internal::writeCodeLengths(output, lengths);
+            output.writeInteger(inputSize);
+
+            for (size_t c = 0; c < R; ++c) {
+                hasCode[c] = lengths[c] > 0;
+            }
+            const bool single = std::count(lengths.begin(), lengths.end(), 0) == R - 1;
+            // a single character is encoded with 0 bits
+            return single ? TrieTable{} : internal::canonicalCodes(lengths);
+        }
+
+        // compress inputSize bytes of input into output using an already generated trie or code lengths
+        template<typename Codes>
+        static void compress(std::istream &input, const uint32_t inputSize, BitStreamOut &output, const Codes &codes) {
+            std::array<bool, R> hasCode{};
+            const TrieTable table = writeHeader(output, inputSize, codes, hasCode);
+            encode(input, inputSize, output, table, hasCode);
+        }
+
+        // write all bytes of input as codes from table; every byte of input must have a code
+        [[maybe_unused]]
+        static void encode(const std::string_view input, BitStreamOut &output, const TrieTable &table) {
+            // split the table so that the loop does not construct ShortBitSets
+            std::array<uint32_t, R> codes{};
+            std::array<uint8_t, R> numBits{};
+            for (size_t c = 0; c < R; ++c) {
+                codes[c] = table[c].value();
+                numBits[c] = static_cast<uint8_t>(table[c].size());
+            }
+            for (const char ch : input) {
+                const auto c = static_cast<uint8_t>(ch);
+                output.writeBits(codes[c], numBits[c]);
+            }
+            output.flush();
+        }
+
+        // count the occurrences of each character in the input
+        [[maybe_unused]]
+        static std::array<int, R> histogram(std::istream &is, uint32_t &numReadBytes) {
+            std::array<int, R> freq{};
+            uint8_t c;
+            numReadBytes = 0;
+            while (is.read(reinterpret_cast<char*>(&c), 1)) {
+                if (numReadBytes == maxInputSize) throw std::runtime_error("Input too large for a single Huffman block");
+                ++freq[c];
+                ++numReadBytes;
+            }
+            return freq;
+        }
+
+        // count the occurrences of each character in the input
+        [[maybe_unused]]
+        static std::array<int, R> histogram(const std::string_view input) {
+            // four tables avoid that consecutive equal characters wait on the same counter
+            std::array<std::array<int, R>, 4> counts{};
+            const auto *data = reinterpret_cast<const uint8_t*>(input.data());
+            const size_t size = input.size();
+            size_t i = 0;
+            for (; i + 4 <= size; i += 4) {
+                ++counts[0][data[i]];
+                ++counts[1][data[i + 1]];
+                ++counts[2][data[i + 2]];
+                ++counts[3][data[i + 3]];
+            }
+            for (; i < size; ++i) {
+                ++counts[0][data[i]];
+            }
+
+            std::array<int, R> freq{};
+            for (size_t c = 0; c < R; ++c) {
+                freq[c] = counts[0][c] + counts[1][c] + counts[2][c] + counts[3][c];
+            }
+            return freq;
+        }
+
+        // compress the input in memory into output, the input is only read twice in memory (histogram and encoding)
+        [[maybe_unused]]
+        static void compress(const std::string_view input, BitStreamOut &output, const Format format = Format::Canonical) {
+            if (input.size() > maxInputSize) {
+                throw std::runtime_error("Input too large for a single Huffman block");
+            }
+            const auto inputSize = static_cast<uint32_t>(input.size());
+            std::array<int, R> freq;
+            {
+                STATS_STAGE(timer, "huffman.histogram", input.size());
+                freq = histogram(input);
+            }
+
+            // codes are built from the input itself, so every byte of it has a code
+            std::array<bool, R> hasCode{};
+            TrieTable table;
+            {
+                STATS_STAGE(timer, "huffman.codes", input.size());
+                if (format == Format::Trie) {
+                    const Trie trieRoot = internal::buildTrie(freq);
+                    if (!trieRoot) throw std::runtime_error("Empty input cannot be compressed in trie format");
+                    table = writeHeader(output, inputSize, *trieRoot, hasCode);
+                } else {
+                    table = writeHeader(output, inputSize, internal::codeLengths(freq), hasCode);
+                }
+            }
+            STATS_STAGE(timer, "huffman.encode", input.size());
+            encode(input, output, table);
+        }
+
         // compress the input, given as two independent streams to the same data, into output
         [[maybe_unused]]
-        static void compress(std::istream &input1, std::istream &input2, BitStreamOut &output) {
+        static void compress(std::istream &input1, std::istream &input2, BitStreamOut &output,
+                             const Format format = Format::Canonical) {
             if (&input1 == &input2) throw std::runtime_error("input1 and input2 may not be the same object");
 
             uint32_t inputSize = 0;
-            const auto trieRoot = huffman::buildTrie(input1, std::ref(inputSize));
+            const std::array<int, R> freq = histogram(input1, inputSize);
+            if (format == Format::Trie) {
+                const Trie trieRoot = internal::buildTrie(freq);
+                if (!trieRoot) throw std::runtime_error("Empty input cannot be compressed in trie format");
+                compress(input2, inputSize, output, *trieRoot);
+            } else {
+                compress(input2, inputSize, output, internal::codeLengths(freq));
+            }
+        }
+
+        // compress symbols of an alphabet with N symbols into output in the canonical format
+        // code lengths are determined with package-merge as the trie nodes can only hold R characters
+        template<size_t N>
+        static void compressSymbols(const std::vector<uint16_t> &symbols, BitStreamOut &output) {
+            if (symbols.size() > maxInputSize) {
+                throw std::runtime_error("Input too large for a single Huffman block");
+            }
+            std::array<int, N> freq{};
+            for (const uint16_t symbol : symbols) {
+                if (symbol >= N) throw std::runtime_error("Symbol is not part of the alphabet");
+                ++freq[symbol];
+            }
+            const std::array<uint8_t, N> lengths = packageMerge(freq, maxCodeLength);
+            writeCodeLengths(output, lengths);
+            output.writeInteger(static_cast<uint32_t>(symbols.size()));
+
+            // a single symbol is encoded with 0 bits
+            if (std::count(lengths.begin(), lengths.end(), 0) < static_cast<std::ptrdiff_t>(N) - 1) {
+                const std::array<ShortBitSet, N> table = canonicalCodes(lengths);
+                std::array<uint32_t, N> codes{};
+                std::array<uint8_t, N> numBits{};
+                for (size_t c = 0; c < N; ++c) {
+                    codes[c] = table[c].value();
+                    numBits[c] = static_cast<uint8_t>(table[c].size());
+                }
+                for (const uint16_t symbol : symbols) {
+                    output.writeBits(codes[symbol], numBits[symbol]);
+                }
+            }
+            output.flush();
+        }
+
+        // decompress symbols of an alphabet with N symbols that were compressed with compressSymbols
+        // @param write called with each decoded symbol
+        template<size_t N, typename Write>
+        static void expandSymbols(BitStreamIn &input, Write write) {
+            const std::array<uint8_t, N> lengths = readCodeLengths<N>(input);
+            const auto numSymbols = input.readInteger<uint32_t>();
+            if (std::count(lengths.begin(), lengths.end(), 0) == static_cast<std::ptrdiff_t>(N) - 1) {
+                const auto single = static_cast<uint16_t>(std::find_if(lengths.begin(), lengths.end(),
+                                                                       [](const uint8_t len) { return len > 0; })
+                                                          - lengths.begin());
+                for (size_t i = 0; i < numSymbols; ++i) write(single);
+                return;
+            }
+            const DecodeTable table(canonicalCodes(lengths));
+            table.decode(input, write, numSymbols);
+        }
+
+        // choose the number of tables: for short inputs, additional tables cost more than they save (as in bzip2)
+        [[maybe_unused]]
+        static size_t numTablesFor(const size_t numSymbols, const size_t maxTables) {
+            const size_t numTables = numSymbols < 200 ? 2 : numSymbols < 600 ? 3 : numSymbols < 1200 ? 4
+                                   : numSymbols < 2400 ? 5 : 6;
+            return std::min(numTables, maxTables);
+        }
+
+        // code tables and the table selected for each group of symbols
+        template<size_t N>
+        struct TablePlan {
+            std::vector<std::array<uint8_t, N>> lengths;
+            std::vector<uint8_t> selectors;
+            size_t numBits; // size of code lengths, selectors and codes
+        };
+
+        // build numTables code tables for the symbols and select one of them for each group of selectorGroupSize
+        // symbols; the tables start with short codes for ranges of symbols of about the same total frequency and
+        // are rebuilt numRefinements times from the groups that selected them, like in bzip2
+        template<size_t N>
+        static TablePlan<N> planTables(const std::vector<uint16_t> &symbols, const std::array<int, N> &freq,
+                                       const size_t numTables) {
+            // initial tables: cost 0 for the symbols in the range of the table, maxCodeLength for all others
+            std::vector<std::array<uint8_t, N>> lengths(numTables);
+            size_t remaining = symbols.size();
+            size_t begin = 0;
+            for (size_t t = 0; t < numTables; ++t) {
+                const size_t target = remaining / (numTables - t);
+                size_t end = begin, sum = 0;
+                while (sum < target && end < N) sum += static_cast<size_t>(freq[end++]);
+                for (size_t c = 0; c < N; ++c) {
+                    lengths[t][c] = c >= begin && c < end ? 0 : maxCodeLength;
+                }
+                remaining -= sum;
+                begin = end;
+            }
+
+            const size_t numGroups = (symbols.size() + selectorGroupSize - 1) / selectorGroupSize;
+            std::vector<uint8_t> selectors(numGroups);
+            size_t codeBits = 0;
+            for (size_t iteration = 0; iteration < numRefinements; ++iteration) {
+                // select the cheapest table for each group
+                std::vector<std::array<int, N>> tableFreq(numTables);
+                for (size_t g = 0; g < numGroups; ++g) {
+                    const size_t first = g * selectorGroupSize;
+                    const size_t last = std::min(first + selectorGroupSize, symbols.size());
+                    std::array<uint32_t, maxNumTables> cost{};
+                    for (size_t i = first; i < last; ++i) {
+                        for (size_t t = 0; t < numTables; ++t) cost[t] += lengths[t][symbols[i]];
+                    }
+                    const auto best = static_cast<uint8_t>(
+                            std::min_element(cost.begin(), cost.begin() + static_cast<std::ptrdiff_t>(numTables))
+                            - cost.begin());
+                    selectors[g] = best;
+                    for (size_t i = first; i < last; ++i) ++tableFreq[best][symbols[i]];
+                }
+                // rebuild the tables, every used symbol needs a code in every table
+                codeBits = 0;
+                for (size_t t = 0; t < numTables; ++t) {
+                    std::array<int, N> weights = tableFreq[t];
+                    for (size_t c = 0; c < N; ++c) {
+                        if (freq[c] > 0 && weights[c] == 0) weights[c] = 1;
+                    }
+                    lengths[t] = packageMerge(weights, maxCodeLength);
+                    for (size_t c = 0; c < N; ++c) {
+                        codeBits += size_t{lengths[t][c]} * static_cast<size_t>(tableFreq[t][c]);
+                    }
+                }
+            }
 
-            compress(input2, inputSize, output, *trieRoot);
+            // bits of the code lengths and the move-to-front coded selectors
+            size_t headerBits = 0;
+            for (const auto &tableLengths : lengths) {
+                int prevLength = -1;
+                for (const uint8_t len : tableLengths) {
+                    if (len == 0) continue;
+                    headerBits += prevLength < 0 ? 7 : 2 * static_cast<size_t>(std::abs(len - prevLength)) + 1;
+                    prevLength = len;
+                }
+            }
+            std::array<uint8_t, maxNumTables> order{};
+            std::iota(order.begin(), order.end(), uint8_t{0});
+            for (const uint8_t selector : selectors) {
+                if (numTables == 1) break; // no selectors needed
+                const auto rank = static_cast<size_t>(std::find(order.begin(), order.end(), selector) - order.begin());
+                std::rotate(order.begin(), order.begin() + static_cast<std::ptrdiff_t>(rank),
+                            order.begin() + static_cast<std::ptrdiff_t>(rank) + 1);
+                headerBits += rank + 1;
+            }
+            return {std::move(lengths), std::move(selectors), headerBits + codeBits};
+        }
+
+        // compress symbols of an alphabet with N symbols into output with up to maxTables code tables
+        // each group of selectorGroupSize symbols is coded with the table that codes it shortest (its selector)
+        // Format: number of symbols (32 bit), used symbols, number of tables (3 bits), delta coded code lengths of
+        // the used symbols for each table, move-to-front coded selectors (rank in unary, none for a single table),
+        // codes
+        template<size_t N>
+        static void compressSymbolsMultiTable(const std::vector<uint16_t> &symbols, BitStreamOut &output,
+                                              const size_t maxTables) {
+            if (maxTables < 1 || maxTables > maxNumTables) throw std::invalid_argument("Invalid number of tables");
+            if (symbols.size() > maxInputSize) {
+                throw std::runtime_error("Input too large for a single Huffman block");
+            }
+            std::array<int, N> freq{};
+            {
+                STATS_STAGE(timer, "huffman.histogram", 2 * symbols.size());
+                for (const uint16_t symbol : symbols) {
+                    if (symbol >= N) throw std::runtime_error("Symbol is not part of the alphabet");
+                    ++freq[symbol];
+                }
+            }
+            std::array<bool, N> used{};
+            for (size_t c = 0; c < N; ++c) used[c] = freq[c] > 0;
+            output.writeInteger(static_cast<uint32_t>(symbols.size()));
+            writeUsedSymbols(output, used);
+            if (std::count(used.begin(), used.end(), true) <= 1) {
+                // a single symbol is encoded with 0 bits
+                output.flush();
+                return;
+            }
+
+            // more tables may not pay off for their code lengths and selectors, e.g. for short or uniform input
+            STATS_STAGE(codesTimer, "huffman.codes", 2 * symbols.size());
+            TablePlan<N> plan = planTables(symbols, freq, numTablesFor(symbols.size(), maxTables));
+            if (plan.lengths.size() > 1) {
+                TablePlan<N> single = planTables(symbols, freq, 1);
+                if (single.numBits <= plan.numBits) plan = std::move(single);
+            }
+            const std::vector<std::array<uint8_t, N>> &lengths = plan.lengths;
+            const std::vector<uint8_t> &selectors = plan.selectors;
+            const size_t numTables = lengths.size();
+            const size_t numGroups = selectors.size();
+
+            output.writeBits(static_cast<uint32_t>(numTables), 3);
+            for (const auto &tableLengths : lengths) writeLengthDeltas(output, tableLengths);
+            std::array<uint8_t, maxNumTables> order{};
+            std::iota(order.begin(), order.end(), uint8_t{0});
+            for (const uint8_t selector : selectors) {
+                if (numTables == 1) break; // all groups use the only table
+                const auto rank = static_cast<size_t>(std::find(order.begin(), order.end(), selector) - order.begin());
+                std::rotate(order.begin(), order.begin() + static_cast<std::ptrdiff_t>(rank),
+                            order.begin() + static_cast<std::ptrdiff_t>(rank) + 1);
+                for (size_t i = 0; i < rank; ++i) output.writeBits(1, 1);
+                output.writeBits(0, 1);
+            }
+
+            // split the tables so that the loop does not construct ShortBitSets
+            std::vector<std::array<uint32_t, N>> codes(numTables);
+            std::vector<std::array<uint8_t, N>> numBits(numTables);
+            for (size_t t = 0; t < numTables; ++t) {
+                const std::array<ShortBitSet, N> table = canonicalCodes(lengths[t]);
+                for (size_t c = 0; c < N; ++c) {
+                    codes[t][c] = table[c].value();
+                    numBits[t][c] = static_cast<uint8_t>(table[c].size());
+                }
+            }
+            STATS_STOP(codesTimer);
+
+            STATS_STAGE(timer, "huffman.encode", 2 * symbols.size());
+            for (size_t g = 0; g < numGroups; ++g) {
+                const auto &groupCodes = codes[selectors[g]];
+                const auto &groupNumBits = numBits[selectors[g]];
+                const size_t last = std::min((g + 1) * selectorGroupSize, symbols.size());
+                for (size_t i = g * selectorGroupSize; i < last; ++i) {
+                    output.writeBits(groupCodes[symbols[i]], groupNumBits[symbols[i]]);
+                }
+            }
+            output.flush();
+        }
+
+        // decompress symbols of an alphabet with N symbols that were compressed with compressSymbolsMultiTable
+        // @param write called with each decoded symbol
+        template<size_t N, typename Write>
+        static void expandSymbolsMultiTable(BitStreamIn &input, Write write) {
+            const auto numSymbols = input.readInteger<uint32_t>();
+            const std::vector<uint16_t> used = readUsedSymbols<N>(input);
+            if (used.size() <= 1) {
+                if (used.empty() && numSymbols > 0) throw std::runtime_error("Invalid code in input");
+                for (size_t i = 0; i < numSymbols; ++i) write(used.front());
+                return;
+            }
+
+            const size_t numTables = input.readBits(3);
+            if (numTables < 1 || numTables > maxNumTables) throw std::runtime_error("Invalid number of tables");
+            std::vector<DecodeTable> tables;
+            for (size_t t = 0; t < numTables; ++t) {
+                tables.emplace_back(canonicalCodes(readLengthDeltas<N>(input, used)));
+            }
+            const size_t numGroups = (size_t{numSymbols} + selectorGroupSize - 1) / selectorGroupSize;
+            std::vector<uint8_t> selectors(numGroups);
+            std::array<uint8_t, maxNumTables> order{};
+            std::iota(order.begin(), order.end(), uint8_t{0});
+            for (uint8_t &selector : selectors) {
+                if (numTables == 1) break; // all groups use the only table
+                size_t rank = 0;
+                while (input.readBits(1)) {
+                    if (++rank >= numTables) throw std::runtime_error("Invalid table selector");
+                }
+                selector = order[rank];
+                std::rotate(order.begin(), order.begin() + static_cast<std::ptrdiff_t>(rank),
+                            order.begin() + static_cast<std::ptrdiff_t>(rank) + 1);
+            }
+
+            for (size_t g = 0; g < numGroups; ++g) {
+                const size_t groupSize = std::min(selectorGroupSize, numSymbols - g * selectorGroupSize);
+                tables[selectors[g]].decode(input, write, groupSize);
+            }
         }
     }
 
 
     // expend encoded input stream into output
     [[maybe_unused]]
-    static void expand(std::istream& is, std::ostream& os) {
+    static void expand(std::istream& is, std::ostream& os, const Format format = Format::Trie) {
         BitStreamIn bsi(is);
         BitStreamOut bso(os);
-        internal::expand(bsi, bso);
+        internal::expand(bsi, bso, format);
     }
 
-    // decompress encoded input string
+    // decompress encoded input buffer
     [[maybe_unused]]
-    static std::string expand(const std::string &inputCompressed) {
-        std::istringstream issComp = std::istringstream(inputCompressed, std::ios::binary);
-        BitStreamIn bsiComp(issComp);
-
-        std::ostringstream oss = std::ostringstream(std::ios::binary);
+    static std::string expand(const std::string_view inputCompressed, const Format format = Format::Trie) {
+        STATS_STAGE(timer, "huffman", inputCompressed.size());
+        MemoryStreamBuf buf(inputCompressed);
+        std::istream isComp(&buf);
+        BitStreamIn bsiComp(isComp);
 
-        BitStreamOut bsoDec(oss);
-        internal::expand(bsiComp, bsoDec);
-        bsoDec.flush();
-
-        return oss.str();
+        // the size is taken from the header, but a corrupted one cannot reserve more than one character per bit, as
+        // each character needs at least one bit unless it is the only one
+        std::string output;
+        internal::expand(bsiComp, [&output](const uint8_t c) { output.push_back(static_cast<char>(c)); },
+                         [&output](const uint8_t c, const size_t n) { output.assign(n, static_cast<char>(c)); },
+                         [&output, &inputCompressed](const size_t n) {
+                             output.reserve(std::min(n, size_t{8} * inputCompressed.size()));
+                         }, format);
+        STATS_OUTPUT(timer, output.size());
+        return output;
     }
 
-    // compress string_view into output string
+    // compress the contiguous input (e.g. a string or a memory mapped file) into output in a single pass over the
+    // same memory, unlike the stream overload which needs to read the input twice
     [[maybe_unused]]
-    static std::string compress(const std::string &input) {
-        std::istringstream iss(input, std::ios::binary);
-        const auto trieRoot = buildTrie(iss);
-
-        // read again for compression
-        iss = std::istringstream(input, std::ios::binary);
+    static void compress(const std::string_view input, std::ostream &output, const Format format = Format::Trie) {
+        BitStreamOut bso(output);
+        internal::compress(input, bso, format);
+    }
 
+    // compress string into output string
+    [[maybe_unused]]
+    static std::string compress(const std::string &input, const Format format = Format::Trie) {
+        STATS_STAGE(timer, "huffman", input.size());
         std::ostringstream oss(std::ios::binary);
-        BitStreamOut bso(oss);
-        internal::compress(iss, input.size(), bso, *trieRoot);
-
-        return oss.str();
+        compress(std::string_view(input), oss, format);
+        std::string output = oss.str();
+        STATS_OUTPUT(timer, output.size());
+        return output;
     }
 
     // compress the input, given as two independent streams to the same data, into output
     [[maybe_unused]]
-    static void compress(std::istream &input1, std::istream &input2, std::ostream& output) {
+    static void compress(std::istream &input1, std::istream &input2, std::ostream& output,
+                         const Format format = Format::Trie) {
         BitStreamOut bso(output);
-        internal::compress(input1, input2, bso);
+        internal::compress(input1, input2, bso, format);
+    }
+
+    // compress symbols of an alphabet with N symbols, which may be more than the R characters of a byte
+    template<size_t N>
+    static std::string compressSymbols(const std::vector<uint16_t> &symbols) {
+        STATS_STAGE(timer, "huffman", 2 * symbols.size());
+        std::ostringstream oss(std::ios::binary);
+        {
+            BitStreamOut bso(oss);
+            internal::compressSymbols<N>(symbols, bso);
+        }
+        std::string output = oss.str();
+        STATS_OUTPUT(timer, output.size());
+        return output;
+    }
+
+    // decompress symbols of an alphabet with N symbols that were compressed with compressSymbols
+    template<size_t N>
+    static std::vector<uint16_t> expandSymbols(const std::string_view inputCompressed) {
+        STATS_STAGE(timer, "huffman", inputCompressed.size());
+        MemoryStreamBuf buf(inputCompressed);
+        std::istream isComp(&buf);
+        BitStreamIn bsiComp(isComp);
+
+        std::vector<uint16_t> symbols;
+        internal::expandSymbols<N>(bsiComp, [&symbols](const uint16_t symbol) { symbols.push_back(symbol); });
+        STATS_OUTPUT(timer, 2 * symbols.size());
+        return symbols;
+    }
+
+    // compress symbols of an alphabet with N symbols with up to maxTables code tables, each group of
+    // selectorGroupSize symbols is coded with one of them; compresses non-stationary input better than
+    // compressSymbols
+    template<size_t N>
+    static std::string compressSymbolsMultiTable(const std::vector<uint16_t> &symbols,
+                                                 const size_t maxTables = maxNumTables) {
+        STATS_STAGE(timer, "huffman", 2 * symbols.size());
+        std::ostringstream oss(std::ios::binary);
+        {
+            BitStreamOut bso(oss);
+            internal::compressSymbolsMultiTable<N>(symbols, bso, maxTables);
+        }
+        std::string output = oss.str();
+        STATS_OUTPUT(timer, output.size());
+        return output;
+    }
+
+    // decompress symbols of an alphabet with N symbols that were compressed with compressSymbolsMultiTable
+    template<size_t N>
+    static std::vector<uint16_t> expandSymbolsMultiTable(const std::string_view inputCompressed) {
+        STATS_STAGE(timer, "huffman", inputCompressed.size());
+        MemoryStreamBuf buf(inputCompressed);
+        std::istream isComp(&buf);
+        BitStreamIn bsiComp(isComp);
+
+        std::vector<uint16_t> symbols;
+        internal::expandSymbolsMultiTable<N>(bsiComp, [&symbols](const uint16_t symbol) { symbols.push_back(symbol); });
+        STATS_OUTPUT(timer, 2 * symbols.size());
+        return symbols;
     }
 
 
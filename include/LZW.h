@@ -3,77 +3,447 @@
 
 #include <istream>
 #include <ostream>
+#include <sstream>
+#include <vector>
+#include <stdexcept>
+#include <algorithm>
+#include <limits>
+#include <string_view>
 #include "BitStreamOut.h"
 #include "BitStreamIn.h"
 #include "external/TernarySearchTrie.h"
+#include "Stats.h"
 
+// Formats:
+//   Fixed: codes of W bits, the dictionary stops growing when it has L entries
+//   Variable: version byte, maximum code width (1 byte), then codes growing from minWidth to the maximum width;
+//             a CLEAR code resets the dictionary when the compression ratio drops after it is full
+// The first byte of the fixed format is at most 0x10 (as its first code is at most R), so the formats can be told
+// apart by the version byte
 namespace lzw {
     constexpr static int R = 256; // number of distinct inputs (8 bits each)
-    constexpr static int L = 4096; // number of codewords, 2^12
-    constexpr static int W = 12; // length in bit of codewords
+    constexpr static int L = 4096; // number of codewords of the fixed format, 2^12
+    constexpr static int W = 12; // length in bit of codewords of the fixed format
+    constexpr static int EOF_CODE = R; // end of data
+    constexpr static int CLEAR_CODE = R + 1; // reset of the dictionary (variable format only)
 
-    [[maybe_unused]]
-    static void compress(std::istream &is, std::ostream &os) {
-        // read complete input into string
-        const std::string stringInput(std::istreambuf_iterator<char>(is), {});
-        std::string_view input = stringInput;
+    constexpr static uint8_t variableVersion = 0x20; // first byte of the variable format
+    constexpr static size_t minWidth = 9; // width of the first codes of the variable format
+    constexpr static size_t maxMaxWidth = 24; // largest supported maximum code width
+    constexpr static size_t defaultMaxWidth = 16;
+    constexpr static size_t checkInterval = 10000; // input bytes between checks of the compression ratio
 
-        // create wrapper for binary writing to ostream
-        BitStreamOut bso(os);
+    enum class Format : uint8_t {
+        Fixed,
+        Variable,
+    };
+
+    // Dictionary of the compressor storing each entry in a ternary search trie
+    // (allocates a node per entry and searches each match from the root again)
+    class TrieDictionary {
+    public:
+        // each entry adds at most one node to the trie, numCodes is bounded by the input size for short input
+        explicit TrieDictionary(const size_t numCodes) : st(numCodes) {
+            reset();
+        }
+
+        // remove all entries except the single characters, the nodes of the trie are reused
+        void reset() {
+            st.clear();
+            for (int i = 0; i < R; ++i) {
+                st.put(std::string(1, static_cast<char>(i)), i);
+            }
+        }
+
+        // find the longest prefix of the non-empty input that is in the dictionary
+        // @return length of the prefix, its code is stored in code
+        size_t match(const std::string_view input, int &code) const {
+            const std::string_view prefix = st.longestPrefixOf(input);
+            code = *st.get(prefix);
+            return prefix.size();
+        }
+
+        // add an entry for the match with prefixCode followed by the next character of input
+        // @param input the input starting at the match
+        void add(const std::string_view input, const size_t matchLength, int /*prefixCode*/, const int code) {
+            st.put(input.substr(0, matchLength + 1), code);
+        }
+    private:
         TernarySearchTrie<int> st;
-        // fill in codewords for "normal" characters
-        for (int i = 0; i < R; ++i) {
-            st.put(std::string(1, static_cast<char>(i)), i);
+    };
+
+    // Dictionary of the compressor storing each entry as (code of its prefix, last character) in a flat hash table
+    // with open addressing, so extending a match by a character needs a single lookup and nothing is allocated after
+    // construction
+    class HashDictionary {
+    public:
+        explicit HashDictionary(const size_t numCodes) {
+            // keep the table at most half full
+            while ((size_t{1} << numBits) < 2 * numCodes) ++numBits;
+            slots.resize(size_t{1} << numBits);
+        }
+
+        // remove all entries except the single characters (which are not stored)
+        void reset() {
+            // slots of older generations are treated as empty, so the table does not have to be cleared
+            if (++generation == 0) {
+                std::fill(slots.begin(), slots.end(), Slot{});
+                generation = 1;
+            }
+        }
+
+        // find the longest prefix of the non-empty input that is in the dictionary
+        // @return length of the prefix, its code is stored in code
+        size_t match(const std::string_view input, int &code) const {
+            code = static_cast<uint8_t>(input[0]);
+            size_t length = 1;
+            while (length < input.size()) {
+                const Slot &slot = slots[find(key(code, input[length]))];
+                if (slot.generation != generation) break;
+                code = static_cast<int>(slot.code);
+                ++length;
+            }
+            return length;
+        }
+
+        // add an entry for the match with prefixCode followed by the next character of input
+        // @param input the input starting at the match
+        void add(const std::string_view input, const size_t matchLength, const int prefixCode, const int code) {
+            const uint32_t k = key(prefixCode, input[matchLength]);
+            slots[find(k)] = {k, static_cast<uint32_t>(code), generation};
         }
+    private:
+        struct Slot {
+            uint32_t key = 0;
+            uint32_t code = 0;
+            uint32_t generation = 0; // entry is only valid if it is the current generation
+        };
+        std::vector<Slot> slots;
+        size_t numBits = 1;
+        uint32_t generation = 1;
 
-        int code = R + 1; // next codeword we can set - reserve R for end-of-file/EOF
-        while (!input.empty()) {
-            std::string_view svLongestPrefix = st.longestPrefixOf(input);
-            bso.writeInteger(*st.get(svLongestPrefix), W); // write encoded form
-            size_t t = svLongestPrefix.size();
-            if (t < input.size() && code < L) {
-                // save new codeword
-                st.put(input.substr(0, t + 1), code++);
-            }
-            // shorten remaining input
-            input = input.substr(t);
+        static uint32_t key(const int prefixCode, const char c) {
+            return (static_cast<uint32_t>(prefixCode) << 8) | static_cast<uint8_t>(c);
         }
-        bso.writeInteger(R, W); // write EOF
+
+        // index of the slot with the key or of the empty slot where it would be inserted
+        [[nodiscard]]
+        size_t find(const uint32_t k) const {
+            const size_t mask = slots.size() - 1;
+            size_t i = (k * uint32_t{0x9E3779B1}) >> (32 - numBits); // Fibonacci hashing
+            while (slots[i].generation == generation && slots[i].key != k) {
+                i = (i + 1) & mask;
+            }
+            return i;
+        }
+    };
+
+    namespace internal {
+        constexpr static size_t chunkSize = 64 * 1024; // bytes read at once by the streaming compressor
+
+        // width of the codes of the variable format, which grows with the number of codes since the last reset
+        // so that it always fits the largest code that may be written next
+        class CodeWidth {
+        public:
+            explicit CodeWidth(const size_t _maxWidth) : maxCode{(int{1} << _maxWidth) - 1} {}
+
+            [[nodiscard]]
+            size_t get() const { return width; }
+
+            // advance after a code was written or read
+            void next() {
+                if (largest < maxCode) ++largest;
+                if (largest >> width) ++width;
+            }
+
+            void reset() {
+                largest = CLEAR_CODE;
+                width = minWidth;
+            }
+        private:
+            int maxCode;
+            int largest = CLEAR_CODE; // largest code that may be written next
+            size_t width = minWidth;
+        };
+
+        // Compressor that consumes its input in pieces, so the input does not have to be in memory at once
+        template<typename Dictionary>
+        class Compressor {
+        public:
+            // writes the header of the format
+            // @param maxInputSize bound of the input size if known, each input byte adds at most one entry, so the
+            //                     dictionary of short input does not need room for all codes
+            Compressor(BitStreamOut &_bso, const Format _format, const size_t maxWidth,
+                       const size_t maxInputSize = std::numeric_limits<size_t>::max())
+                    : bso{_bso}, format{_format}, numCodes{format == Format::Fixed ? L : int{1} << maxWidth},
+                      firstCode{format == Format::Fixed ? R + 1 : CLEAR_CODE + 1}, code{firstCode},
+                      dictionary(maxInputSize < static_cast<size_t>(numCodes - firstCode)
+                                 ? static_cast<size_t>(firstCode) + maxInputSize : static_cast<size_t>(numCodes)),
+                      width(maxWidth) {
+                if (format == Format::Variable) {
+                    bso.writeInteger(variableVersion);
+                    bso.writeInteger(static_cast<uint8_t>(maxWidth));
+                }
+            }
+            Compressor() = delete;
+            Compressor(Compressor&& rhs) = delete;
+            Compressor(const Compressor& rhs) = delete;
+            Compressor& operator=(const Compressor& rhs) = delete;
+
+            // compress the input up to its last match, which may continue in the next piece
+            // @param final whether this is the last piece of the input, then all of it is compressed
+            // @return number of consumed bytes, the rest has to be passed again in front of the next piece
+            size_t compress(std::string_view input, const bool final) {
+                const size_t size = input.size();
+                while (!input.empty()) {
+                    int matchCode;
+                    const size_t t = dictionary.match(input, matchCode);
+                    if (t == input.size() && !final) break; // the match may continue in the next piece
+                    write(matchCode); // write encoded form
+                    numIn += t;
+                    if (t < input.size()) learn(input, t, matchCode);
+                    // shorten remaining input
+                    input.remove_prefix(t);
+                }
+                return size - input.size();
+            }
+
+            // write EOF after all input was compressed
+            void finish() {
+                write(EOF_CODE);
+            }
+        private:
+            BitStreamOut &bso;
+            Format format;
+            int numCodes; // number of codes that can be assigned
+            int firstCode; // first code of a new entry
+            int code; // next codeword we can set
+            Dictionary dictionary;
+            CodeWidth width; // only for the variable format
+
+            // like compress(1), reset the full dictionary as soon as the compression ratio drops (variable format)
+            size_t numIn = 0; // input bytes since the last reset
+            size_t numOutBits = 0; // output bits since the last reset
+            size_t nextCheck = checkInterval;
+            double ratio = 0;
+
+            void write(const int c) {
+                const size_t numBits = format == Format::Fixed ? W : width.get();
+                bso.writeInteger(c, numBits);
+                numOutBits += numBits;
+                width.next();
+            }
+
+            // save a new codeword for the match followed by the next character, or check the compression ratio
+            void learn(const std::string_view input, const size_t matchLength, const int matchCode) {
+                if (code < numCodes) {
+                    dictionary.add(input, matchLength, matchCode, code++);
+                } else if (format == Format::Variable && numIn >= nextCheck) {
+                    nextCheck = numIn + checkInterval;
+                    const double newRatio = static_cast<double>(numIn) / static_cast<double>(numOutBits);
+                    if (newRatio < ratio) {
+                        bso.writeInteger(CLEAR_CODE, width.get());
+                        dictionary.reset();
+                        code = firstCode;
+                        width.reset();
+                        numIn = numOutBits = 0;
+                        nextCheck = checkInterval;
+                        ratio = 0;
+                    } else {
+                        ratio = newRatio;
+                    }
+                }
+            }
+        };
+
+        // Dictionary of the expander, each entry refers to the entry of its prefix instead of storing a string, so
+        // expanding a code writes its characters backwards directly into the output buffer and does not allocate
+        class Expander {
+        public:
+            constexpr static size_t bufferSize = 64 * 1024;
+
+            // @param firstCode first code that is assigned to a new entry
+            Expander(std::ostream &_os, const size_t _numCodes, const int _firstCode)
+                    : os{_os}, numCodes{_numCodes}, firstCode{static_cast<size_t>(_firstCode)}, buffer(bufferSize) {
+                entries.reserve(std::min(numCodes, size_t{1} << 16)); // grows further if the input needs it
+                for (int c = 0; c < R; ++c) {
+                    entries.push_back({0, 1, static_cast<uint8_t>(c), static_cast<uint8_t>(c)});
+                }
+                entries.resize(firstCode); // codes between R and firstCode are never expanded
+            }
+            Expander() = delete;
+            Expander(Expander&& rhs) = delete;
+            Expander(const Expander& rhs) = delete;
+            Expander& operator=(const Expander& rhs) = delete;
+
+            // remove all entries except the single characters
+            void reset() {
+                entries.resize(firstCode); // keeps the capacity
+                prev = noCode;
+            }
+
+            // write the characters of code and add an entry for the previous code followed by the first character
+            void expand(const size_t code) {
+                const size_t next = entries.size();
+                if (code > next || (code == next && prev == noCode) || (code >= R && code < firstCode)) {
+                    throw std::runtime_error("Invalid LZW code");
+                }
+                if (prev != noCode && next < numCodes) {
+                    const Entry &p = entries[prev];
+                    // if code is the entry that is added now (invalid lookahead), it starts like the previous code
+                    const uint8_t c = code == next ? p.first : entries[code].first;
+                    entries.push_back({static_cast<uint32_t>(prev), p.length + 1, c, p.first});
+                }
+                write(code);
+                prev = code;
+            }
+
+            void flush() {
+                os.write(buffer.data(), static_cast<std::streamsize>(pos));
+                pos = 0;
+            }
+
+            ~Expander() {
+                flush();
+            }
+        private:
+            struct Entry {
+                uint32_t prefix; // code of the entry without its last character
+                uint32_t length; // number of characters
+                uint8_t last; // last character
+                uint8_t first; // first character
+            };
+            constexpr static size_t noCode = std::numeric_limits<size_t>::max();
+
+            std::ostream &os;
+            size_t numCodes;
+            size_t firstCode;
+            std::vector<Entry> entries;
+            size_t prev = noCode; // previously expanded code
+            std::vector<char> buffer; // output that was not written to os yet
+            size_t pos = 0; // number of bytes in buffer
+
+            void write(size_t code) {
+                const size_t length = entries[code].length;
+                if (buffer.size() - pos < length) {
+                    flush();
+                    if (buffer.size() < length) buffer.resize(length); // only for very long entries
+                }
+                char *out = buffer.data() + pos + length;
+                pos += length;
+                for (size_t i = 0; i < length; ++i) {
+                    const Entry &entry = entries[code];
+                    *--out = static_cast<char>(entry.last);
+                    code = entry.prefix;
+                }
+            }
+        };
+
+        [[maybe_unused]]
+        static void expandFixed(BitStreamIn &bsi, std::ostream &os) {
+            Expander expander(os, L, R + 1); // R is EOF
+            while (true) {
+                const auto codeword = static_cast<size_t>(bsi.readBits(W));
+                if (codeword == EOF_CODE) break;
+                expander.expand(codeword);
+            }
+        }
+
+        [[maybe_unused]]
+        static void expandVariable(BitStreamIn &bsi, std::ostream &os) {
+            if (bsi.readInteger<uint8_t>() != variableVersion) throw std::runtime_error("Unsupported LZW version");
+            const auto maxWidth = bsi.readInteger<uint8_t>();
+            if (maxWidth < minWidth || maxWidth > maxMaxWidth) throw std::runtime_error("Invalid LZW code width");
+
+            Expander expander(os, size_t{1} << maxWidth, CLEAR_CODE + 1);
+            CodeWidth width(maxWidth);
+            while (true) {
+                const auto codeword = static_cast<size_t>(bsi.readBits(width.get()));
+                width.next();
+                if (codeword == EOF_CODE) break;
+                if (codeword == CLEAR_CODE) {
+                    expander.reset();
+                    width.reset();
+                    continue;
+                }
+                expander.expand(codeword);
+            }
+        }
+    }
+
+    // compress input into output, reading it in chunks of internal::chunkSize bytes, so memory usage does not
+    // depend on the input size
+    // @param maxWidth maximum code width of the variable format (minWidth to maxMaxWidth)
+    // @tparam Dictionary HashDictionary or TrieDictionary, which produce the same output
+    template<typename Dictionary = HashDictionary>
+    static void compress(std::istream &is, std::ostream &os, const Format format = Format::Variable,
+                         const size_t maxWidth = defaultMaxWidth) {
+        if (maxWidth < minWidth || maxWidth > maxMaxWidth) throw std::invalid_argument("Invalid LZW code width");
+
+        // create wrapper for binary writing to ostream
+        BitStreamOut bso(os);
+        internal::Compressor<Dictionary> compressor(bso, format, maxWidth);
+
+        // the unconsumed rest of a chunk is at most as long as the longest dictionary entry
+        std::string buf;
+        size_t numLeft = 0;
+        while (true) {
+            buf.resize(numLeft + internal::chunkSize);
+            is.read(buf.data() + numLeft, static_cast<std::streamsize>(internal::chunkSize));
+            buf.resize(numLeft + static_cast<size_t>(is.gcount()));
+            const bool final = !is;
+
+            const size_t numConsumed = compressor.compress(buf, final);
+            numLeft = buf.size() - numConsumed;
+            if (final) break;
+            buf.erase(0, numConsumed);
+        }
+        compressor.finish();
         bso.flush();
     }
 
+    // expand input of any format into output
     [[maybe_unused]]
     static void expand(std::istream &is, std::ostream &os) {
-        BitStreamIn bsi(is);
+        const auto first = is.peek();
+        if (first == std::istream::traits_type::eof()) throw std::runtime_error("Stream finished unexpectedly");
 
-        std::array<std::string,L> st; // symbol table for lookup
-        int i; // next available codeword value
-        for (i=0; i < R; ++i) {
-            st[i] = std::string(1, static_cast<char>(i));
-        }
-        st[i++] = " "; // unused, EOF
-        int codeword = bsi.readInteger<int>(W);
-        std::string val = st[codeword];
-        while (true) {
-            os.write(val.c_str(), val.size()); // write current data
-            codeword = bsi.readInteger<int>(W);
-            if (codeword == R) {
-                // EOF
-                break;
-            }
-            std::string s = st[codeword];
-            if (i == codeword) {
-                // special case of invalid lookahead - make codeword from last one
-                s = val + val[0];
-            }
-            if (i < L) {
-                // add new entry to table
-                st[i++] = val + s[0];
-            }
-            val = std::move(s);
+        BitStreamIn bsi(is);
+        if (first == variableVersion) {
+            internal::expandVariable(bsi, os);
+        } else {
+            internal::expandFixed(bsi, os);
         }
     }
 
+    // compress string into output string
+    template<typename Dictionary = HashDictionary>
+    static std::string compress(const std::string& input, const Format format = Format::Variable,
+                                const size_t maxWidth = defaultMaxWidth) {
+        if (maxWidth < minWidth || maxWidth > maxMaxWidth) throw std::invalid_argument("Invalid LZW code width");
 
+        STATS_STAGE(timer, "lzw", input.size());
+        std::ostringstream oss(std::ios::binary);
+        BitStreamOut bso(oss);
+        internal::Compressor<Dictionary> compressor(bso, format, maxWidth, input.size());
+        compressor.compress(input, true);
+        compressor.finish();
+        bso.flush();
+        std::string output = oss.str();
+        STATS_OUTPUT(timer, output.size());
+        return output;
+    }
+
+    // decompress encoded input string
+    [[maybe_unused]]
+    static std::string expand(const std::string& inputCompressed) {
+        STATS_STAGE(timer, "lzw", inputCompressed.size());
+        std::istringstream iss(inputCompressed, std::ios::binary);
+        std::ostringstream oss(std::ios::binary);
+        expand(iss, oss);
+        std::string output = oss.str();
+        STATS_OUTPUT(timer, output.size());
+        return output;
+    }
 } // lzw
 #endif //STRING_PROCESSING_CPP_LZW_H
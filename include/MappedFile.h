@@ -0,0 +1,56 @@
+#ifndef COMPRESSION_CPP_MAPPEDFILE_H
+#define COMPRESSION_CPP_MAPPEDFILE_H
+
+#include <string>
+#include <string_view>
+#include <stdexcept>
+#include <cstring>
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Read-only memory mapping of a whole regular file (POSIX)
+class MappedFile {
+public:
+    explicit MappedFile(const std::string& filename) {
+        const int fd = ::open(filename.c_str(), O_RDONLY);
+        if (fd < 0) throw std::runtime_error("Cannot open " + filename + ": " + std::strerror(errno));
+
+        struct stat st{};
+        if (::fstat(fd, &st) != 0 || !S_ISREG(st.st_mode)) {
+            ::close(fd);
+            throw std::runtime_error("Cannot map " + filename + ": not a regular file");
+        }
+        size = static_cast<size_t>(st.st_size);
+        if (size > 0) { // empty files cannot be mapped
+            data = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (data == MAP_FAILED) {
+                ::close(fd);
+                throw std::runtime_error("Cannot map " + filename + ": " + std::strerror(errno));
+            }
+            // the input is read from front to back, so the kernel may read ahead aggressively
+            ::madvise(data, size, MADV_SEQUENTIAL);
+        }
+        ::close(fd); // the mapping stays valid
+    }
+    MappedFile() = delete;
+    MappedFile(MappedFile&& rhs) = delete;
+    MappedFile(const MappedFile& rhs) = delete;
+    MappedFile& operator=(const MappedFile& rhs) = delete;
+
+    [[nodiscard]]
+    std::string_view view() const {
+        return {static_cast<const char*>(data), size};
+    }
+
+    ~MappedFile() {
+        if (data) ::munmap(data, size);
+    }
+private:
+    void* data = nullptr;
+    size_t size = 0;
+};
+
+#endif //COMPRESSION_CPP_MAPPEDFILE_H
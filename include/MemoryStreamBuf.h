@@ -0,0 +1,32 @@
+#ifndef COMPRESSION_CPP_MEMORYSTREAMBUF_H
+#define COMPRESSION_CPP_MEMORYSTREAMBUF_H
+
+#include <streambuf>
+#include <string_view>
+
+// std::streambuf reading directly from memory, so std::istream can be used on buffers or a
+// MappedFile without copying them
+class MemoryStreamBuf : public std::streambuf {
+public:
+    explicit MemoryStreamBuf(const std::string_view _data) {
+        char* begin = const_cast<char*>(_data.data()); // the get area is never written to
+        setg(begin, begin, begin + _data.size());
+    }
+protected:
+    pos_type seekoff(const off_type off, const std::ios_base::seekdir dir, const std::ios_base::openmode which) override {
+        if (!(which & std::ios_base::in)) return pos_type(off_type(-1));
+        off_type base = 0;
+        if (dir == std::ios_base::cur) base = gptr() - eback();
+        else if (dir == std::ios_base::end) base = egptr() - eback();
+        const off_type pos = base + off;
+        if (pos < 0 || pos > egptr() - eback()) return pos_type(off_type(-1));
+        setg(eback(), eback() + pos, egptr());
+        return pos_type(pos);
+    }
+
+    pos_type seekpos(const pos_type pos, const std::ios_base::openmode which) override {
+        return seekoff(off_type(pos), std::ios_base::beg, which);
+    }
+};
+
+#endif //COMPRESSION_CPP_MEMORYSTREAMBUF_H
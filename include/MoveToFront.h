@@ -3,55 +3,323 @@
 
 #include <istream>
 #include <ostream>
+#include <string>
 #include <array>
 #include <numeric>
+#include <cstdint>
+#include <algorithm>
+#include "Stats.h"
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#define MTF_X86_KERNELS 1
+#include <immintrin.h>
+#endif
 
 namespace mtf {
+    constexpr static int R = 256;
+
+    namespace internal {
+        constexpr static size_t chunkSize = 64 * 1024; // bytes processed at once by the stream functions
+
+        // current order of the characters, kept between chunks of the same input
+        // the vector kernels only update charByRank and leave rankByChar stale, so a state must never be shared
+        // between the scalar and the vector kernels
+        struct State {
+            alignas(32) std::array<uint8_t, R> charByRank{}; // aligned for the vector loads
+            std::array<uint8_t, R> rankByChar{};
+
+            State() {
+                std::iota(charByRank.begin(), charByRank.end(), 0); // fill with index
+                std::iota(rankByChar.begin(), rankByChar.end(), 0); // fill with index
+            }
+        };
+
+        // replace each character of data by its current rank (scalar kernel)
+        [[maybe_unused]]
+        static void encode(State& state, char* data, const size_t size) {
+            auto& [charByRank, rankByChar] = state;
+            for (size_t j = 0; j < size; ++j) {
+                const auto c = static_cast<uint8_t>(data[j]);
+                const uint8_t rankC = rankByChar[c];
+                data[j] = static_cast<char>(rankC); // write current index of c
+                // shuffle to the right
+                for (int i = rankC; i > 0; --i) {
+                    rankByChar[charByRank[i-1]]  = i;
+                    charByRank[i] = charByRank[i - 1];
+                }
+                rankByChar[c] = 0;
+                charByRank[0] = c;
+            }
+        }
+
+        // replace each rank in data by the character it stands for (scalar kernel)
+        [[maybe_unused]]
+        static void decode(State& state, char* data, const size_t size) {
+            auto& [charByRank, rankByChar] = state;
+            for (size_t j = 0; j < size; ++j) {
+                const auto rankC = static_cast<uint8_t>(data[j]);
+                const uint8_t c = charByRank[rankC];
+                data[j] = static_cast<char>(c); // write decoded char
+
+                // shuffle to the right
+                for (int i=rankC; i > 0; --i) {
+                    charByRank[i] = charByRank[i-1];
+                    rankByChar[charByRank[i-1]] = i;
+                }
+                charByRank[0] = c;
+                rankByChar[c] = 0;
+            }
+        }
+
+#ifdef MTF_X86_KERNELS
+        // SSE2 and AVX2 kernels only use charByRank: the rank of a character is found with vector compares and the
+        // ranks before it are shifted with vector instructions
+
+        // rank of c in charByRank
+        [[maybe_unused]] __attribute__((target("sse2")))
+        static size_t findSSE2(const uint8_t* charByRank, const uint8_t c) {
+            const __m128i needle = _mm_set1_epi8(static_cast<char>(c));
+            for (size_t i = 0; i < R; i += 16) {
+                const __m128i chars = _mm_loadu_si128(reinterpret_cast<const __m128i*>(charByRank + i));
+                const auto mask = static_cast<unsigned>(_mm_movemask_epi8(_mm_cmpeq_epi8(chars, needle)));
+                if (mask) return i + static_cast<size_t>(__builtin_ctz(mask));
+            }
+            return 0; // unreachable, every character has a rank
+        }
+
+        // move the characters of the ranks below rank one rank up and c to the front
+        [[maybe_unused]] __attribute__((target("sse2")))
+        static inline void moveToFrontSSE2(uint8_t* charByRank, size_t rank, const uint8_t c) {
+            // from the top, so each block is loaded before it is overwritten
+            while (rank >= 16) {
+                rank -= 16;
+                const __m128i chars = _mm_loadu_si128(reinterpret_cast<const __m128i*>(charByRank + rank));
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(charByRank + rank + 1), chars);
+            }
+            // the first block is shifted in a register and c is inserted before it is stored, so the next search
+            // can load it directly from the store
+            const __m128i chars = _mm_loadu_si128(reinterpret_cast<const __m128i*>(charByRank));
+            const __m128i index = _mm_setr_epi8(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15);
+            const __m128i moved = _mm_cmplt_epi8(index, _mm_set1_epi8(static_cast<char>(rank + 1)));
+            const __m128i shifted = _mm_or_si128(_mm_slli_si128(chars, 1), _mm_cvtsi32_si128(c));
+            const __m128i result = _mm_or_si128(_mm_and_si128(moved, shifted), _mm_andnot_si128(moved, chars));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(charByRank), result);
+        }
+
+        [[maybe_unused]] __attribute__((target("sse2")))
+        static void encodeSSE2(State& state, char* data, const size_t size) {
+            uint8_t* charByRank = state.charByRank.data();
+            for (size_t j = 0; j < size; ++j) {
+                const auto c = static_cast<uint8_t>(data[j]);
+                if (c == charByRank[0]) { // most common case after the Burrows-Wheeler transform
+                    data[j] = 0;
+                    continue;
+                }
+                const size_t rankC = findSSE2(charByRank, c);
+                data[j] = static_cast<char>(rankC);
+                moveToFrontSSE2(charByRank, rankC, c);
+            }
+        }
+
+        [[maybe_unused]] __attribute__((target("sse2")))
+        static void decodeSSE2(State& state, char* data, const size_t size) {
+            uint8_t* charByRank = state.charByRank.data();
+            for (size_t j = 0; j < size; ++j) {
+                const auto rankC = static_cast<uint8_t>(data[j]);
+                const uint8_t c = charByRank[rankC];
+                data[j] = static_cast<char>(c);
+                if (rankC > 0) moveToFrontSSE2(charByRank, rankC, c);
+            }
+        }
+
+        // The AVX2 kernels keep all 256 ranks in eight registers instead of memory, so the next character does not
+        // wait for the shifted ranks to be stored and loaded again
+        struct RanksAVX2 {
+            __m256i blocks[8];
+        };
+
+        [[maybe_unused]] __attribute__((target("avx2")))
+        static inline RanksAVX2 loadAVX2(const uint8_t* charByRank) {
+            RanksAVX2 ranks;
+#pragma GCC unroll 8
+            for (size_t k = 0; k < 8; ++k) {
+                ranks.blocks[k] = _mm256_load_si256(reinterpret_cast<const __m256i*>(charByRank + 32 * k));
+            }
+            return ranks;
+        }
+
+        [[maybe_unused]] __attribute__((target("avx2")))
+        static inline void storeAVX2(const RanksAVX2& ranks, uint8_t* charByRank) {
+#pragma GCC unroll 8
+            for (size_t k = 0; k < 8; ++k) {
+                _mm256_store_si256(reinterpret_cast<__m256i*>(charByRank + 32 * k), ranks.blocks[k]);
+            }
+        }
+
+        // move the characters of the ranks below rank one rank up and c to the front
+        [[maybe_unused]] __attribute__((target("avx2")))
+        static inline void moveToFrontAVX2(RanksAVX2& ranks, const size_t rank, const uint8_t c) {
+            const __m256i index = _mm256_setr_epi8(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16, 17, 18,
+                                                   19, 20, 21, 22, 23, 24, 25, 26, 27, 28, 29, 30, 31);
+            // from the top, so each block still has the last character of the block below
+#pragma GCC unroll 8
+            for (size_t k = 8; k-- > 0;) {
+                const __m256i block = ranks.blocks[k];
+                const __m256i below = k > 0 ? ranks.blocks[k - 1] : _mm256_set1_epi8(static_cast<char>(c));
+                // shift by one byte across the two lanes, filling in the last byte of below
+                const __m256i shifted = _mm256_alignr_epi8(block, _mm256_permute2x128_si256(block, below, 0x03), 15);
+                // number of bytes of this block at ranks up to rank
+                const auto numMoved = static_cast<char>(std::min<size_t>(rank + 1 - std::min(rank + 1, 32 * k), 32));
+                const __m256i moved = _mm256_cmpgt_epi8(_mm256_set1_epi8(numMoved), index);
+                ranks.blocks[k] = _mm256_blendv_epi8(block, shifted, moved);
+            }
+        }
+
+        [[maybe_unused]] __attribute__((target("avx2")))
+        static void encodeAVX2(State& state, char* data, const size_t size) {
+            RanksAVX2 ranks = loadAVX2(state.charByRank.data());
+            uint8_t front = state.charByRank[0]; // character at rank 0
+            for (size_t j = 0; j < size; ++j) {
+                const auto c = static_cast<uint8_t>(data[j]);
+                if (c == front) { // most common case after the Burrows-Wheeler transform
+                    data[j] = 0;
+                    continue;
+                }
+                front = c;
+                const __m256i needle = _mm256_set1_epi8(static_cast<char>(c));
+                size_t rankC = 0;
+#pragma GCC unroll 8
+                for (size_t k = 0; k < 8; ++k) {
+                    const auto mask = static_cast<unsigned>(
+                            _mm256_movemask_epi8(_mm256_cmpeq_epi8(ranks.blocks[k], needle)));
+                    if (mask) {
+                        rankC = 32 * k + static_cast<size_t>(__builtin_ctz(mask));
+                        break;
+                    }
+                }
+                data[j] = static_cast<char>(rankC);
+                moveToFrontAVX2(ranks, rankC, c);
+            }
+            storeAVX2(ranks, state.charByRank.data());
+        }
+
+        [[maybe_unused]] __attribute__((target("avx2")))
+        static void decodeAVX2(State& state, char* data, const size_t size) {
+            const __m256i index = _mm256_setr_epi8(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16, 17, 18,
+                                                   19, 20, 21, 22, 23, 24, 25, 26, 27, 28, 29, 30, 31);
+            RanksAVX2 ranks = loadAVX2(state.charByRank.data());
+            uint8_t front = state.charByRank[0]; // character at rank 0
+            for (size_t j = 0; j < size; ++j) {
+                const auto rankC = static_cast<uint8_t>(data[j]);
+                if (rankC == 0) { // most common case after the Burrows-Wheeler transform
+                    data[j] = static_cast<char>(front);
+                    continue;
+                }
+                // select the character at rankC without indexing the registers: keep only its byte and sum up
+                const __m256i position = _mm256_set1_epi8(static_cast<char>(rankC));
+                __m256i selected = _mm256_setzero_si256();
+#pragma GCC unroll 8
+                for (size_t k = 0; k < 8; ++k) {
+                    const __m256i blockIndex = _mm256_add_epi8(index, _mm256_set1_epi8(static_cast<char>(32 * k)));
+                    const __m256i match = _mm256_cmpeq_epi8(blockIndex, position);
+                    selected = _mm256_or_si256(selected, _mm256_and_si256(ranks.blocks[k], match));
+                }
+                const __m256i sums = _mm256_sad_epu8(selected, _mm256_setzero_si256());
+                const __m128i sum = _mm_add_epi64(_mm256_castsi256_si128(sums), _mm256_extracti128_si256(sums, 1));
+                const auto c = static_cast<uint8_t>(_mm_cvtsi128_si32(_mm_add_epi64(sum, _mm_unpackhi_epi64(sum, sum))));
+                data[j] = static_cast<char>(c);
+                moveToFrontAVX2(ranks, rankC, c);
+                front = c;
+            }
+            storeAVX2(ranks, state.charByRank.data());
+        }
+#endif
+
+        // transform of a chunk of data, which has to be used for all chunks of the same input
+        using Kernel = void (*)(State&, char*, size_t);
+
+        [[maybe_unused]]
+        static bool supportsSSE2() {
+#ifdef MTF_X86_KERNELS
+            return __builtin_cpu_supports("sse2"); // always true on x86-64
+#else
+            return false;
+#endif
+        }
+
+        [[maybe_unused]]
+        static bool supportsAVX2() {
+#ifdef MTF_X86_KERNELS
+            return __builtin_cpu_supports("avx2");
+#else
+            return false;
+#endif
+        }
+
+        // fastest encode kernel supported by the CPU
+        // the AVX2 kernels are kept for comparison in compression_bench only: each rank has to go through a general
+        // purpose register before the registers can be shifted, which made them slower than the SSE2 kernels
+        [[maybe_unused]]
+        static Kernel encodeKernel() {
+#ifdef MTF_X86_KERNELS
+            static const Kernel kernel = supportsSSE2() ? encodeSSE2 : encode;
+            return kernel;
+#else
+            return encode;
+#endif
+        }
+
+        // fastest decode kernel supported by the CPU
+        [[maybe_unused]]
+        static Kernel decodeKernel() {
+#ifdef MTF_X86_KERNELS
+            static const Kernel kernel = supportsSSE2() ? decodeSSE2 : decode;
+            return kernel;
+#else
+            return decode;
+#endif
+        }
+
+        // apply transform to the input stream in chunks
+        static void transformStream(std::istream& is, std::ostream& os, const Kernel transform) {
+            State state;
+            std::string buf(chunkSize, '\0');
+            while (is.read(buf.data(), static_cast<std::streamsize>(buf.size())) || is.gcount() > 0) {
+                const auto n = static_cast<size_t>(is.gcount());
+                transform(state, buf.data(), n);
+                os.write(buf.data(), static_cast<std::streamsize>(n));
+            }
+        }
+    }
+
+    // apply move-to-front encoding in place
+    [[maybe_unused]]
+    static void encode(std::string& buf) {
+        STATS_STAGE(timer, "mtf", buf.size());
+        STATS_OUTPUT(timer, buf.size());
+        internal::State state;
+        internal::encodeKernel()(state, buf.data(), buf.size());
+    }
+
+    // reverse move-to-front encoding in place
+    [[maybe_unused]]
+    static void decode(std::string& buf) {
+        STATS_STAGE(timer, "mtf", buf.size());
+        STATS_OUTPUT(timer, buf.size());
+        internal::State state;
+        internal::decodeKernel()(state, buf.data(), buf.size());
+    }
+
     // apply move-to-front encoding
     [[maybe_unused]]
     static void encode(std::istream& is, std::ostream& os) {
-        constexpr int R = 256;
-        std::array<uint8_t, R> charByRank{};
-        std::array<uint8_t, R> rankByChar{};
-        std::iota(charByRank.begin(), charByRank.end(), 0); // fill with index
-        std::iota(rankByChar.begin(), rankByChar.end(), 0); // fill with index
-
-        uint8_t c;
-        while (is.read(reinterpret_cast<char*>(&c), 1)) {
-            uint8_t rankC = rankByChar[c];
-            os.write(reinterpret_cast<const char*>(&rankC), 1); // write current index of c
-            // shuffle to the right
-            for (int i = rankC; i > 0; --i) {
-                rankByChar[charByRank[i-1]]  = i;
-                charByRank[i] = charByRank[i - 1];
-            }
-            rankByChar[c] = 0;
-            charByRank[0] = c;
-        }
+        internal::transformStream(is, os, internal::encodeKernel());
     }
 
     // reverse move-to-front encoding
     [[maybe_unused]]
     static void decode(std::istream& is, std::ostream& os) {
-        constexpr int R = 256;
-        std::array<uint8_t, R> charByRank{};
-        std::array<uint8_t, R> rankByChar{};
-        std::iota(charByRank.begin(), charByRank.end(), 0); // fill with index
-        std::iota(rankByChar.begin(), rankByChar.end(), 0); // fill with index
-
-        uint8_t rankC;
-        while (is.read(reinterpret_cast<char*>(&rankC), 1)) {
-            uint8_t c = charByRank[rankC];
-            os.write(reinterpret_cast<const char*>(&c), 1); // write decoded char
-
-            // shuffle to the right
-            for (int i=rankC; i > 0; --i) {
-                charByRank[i] = charByRank[i-1];
-                rankByChar[charByRank[i-1]] = i;
-            }
-            charByRank[0] = c;
-            rankByChar[c] = 0;
-        }
+        internal::transformStream(is, os, internal::decodeKernel());
     }
 }
 
@@ -0,0 +1,99 @@
+#ifndef COMPRESSION_CPP_NODEPOOL_H
+#define COMPRESSION_CPP_NODEPOOL_H
+
+#include <vector>
+#include <memory>
+#include <new>
+#include <cstddef>
+#include <type_traits>
+#include <utility>
+
+// Arena for the nodes of a trie: nodes are placed one after another in contiguous blocks, which double in size when
+// they are full, and are all released at once. Releasing is O(1) for trivially destructible nodes, and clear keeps
+// the blocks for the next nodes, so a structure that is rebuilt repeatedly does not allocate again.
+template<typename T>
+class NodePool {
+public:
+    explicit NodePool(const size_t initialCapacity = 64) :
+            initialCapacity{initialCapacity > 0 ? initialCapacity : 1} {}
+    NodePool(const NodePool& rhs) = delete;
+    NodePool& operator=(const NodePool& rhs) = delete;
+    // the nodes stay where they are when the pool is moved
+    NodePool(NodePool&& rhs) noexcept : initialCapacity{rhs.initialCapacity}, blocks{std::move(rhs.blocks)},
+                                        current{std::exchange(rhs.current, 0)}, used{std::exchange(rhs.used, 0)},
+                                        numNodes{std::exchange(rhs.numNodes, 0)} {
+        rhs.blocks.clear();
+    }
+    NodePool& operator=(NodePool&& rhs) noexcept {
+        if (this != &rhs) {
+            clear();
+            initialCapacity = rhs.initialCapacity;
+            blocks = std::move(rhs.blocks);
+            rhs.blocks.clear();
+            current = std::exchange(rhs.current, 0);
+            used = std::exchange(rhs.used, 0);
+            numNodes = std::exchange(rhs.numNodes, 0);
+        }
+        return *this;
+    }
+
+    ~NodePool() {
+        clear();
+    }
+
+    // construct a node in the pool, it stays valid until the pool is cleared or destroyed
+    template<typename... Args>
+    T* create(Args&&... args) {
+        if (blocks.empty() || used == blocks[current].capacity) {
+            if (!blocks.empty()) ++current;
+            if (current == blocks.size()) {
+                const size_t capacity = blocks.empty() ? initialCapacity : 2 * blocks.back().capacity;
+                // the slots are left uninitialized, nodes are constructed in them as they are created
+                blocks.push_back({std::unique_ptr<Slot[]>(new Slot[capacity]), capacity});
+            }
+            used = 0;
+        }
+        T* node = new (&blocks[current].slots[used]) T(std::forward<Args>(args)...);
+        ++used;
+        ++numNodes;
+        return node;
+    }
+
+    // destroy all nodes, but keep the memory for new ones
+    void clear() {
+        if constexpr (!std::is_trivially_destructible_v<T>) {
+            for (size_t b = 0; b < blocks.size() && b <= current; ++b) {
+                const size_t end = b == current ? used : blocks[b].capacity;
+                for (size_t i = 0; i < end; ++i) {
+                    std::launder(reinterpret_cast<T*>(&blocks[b].slots[i]))->~T();
+                }
+            }
+        }
+        current = 0;
+        used = 0;
+        numNodes = 0;
+    }
+
+    // number of nodes in the pool
+    [[nodiscard]]
+    size_t size() const {
+        return numNodes;
+    }
+
+private:
+    struct alignas(T) Slot {
+        std::byte data[sizeof(T)];
+    };
+    struct Block {
+        std::unique_ptr<Slot[]> slots;
+        size_t capacity;
+    };
+
+    size_t initialCapacity;
+    std::vector<Block> blocks;
+    size_t current = 0; // index of the block that receives the next node
+    size_t used = 0; // number of nodes in the current block
+    size_t numNodes = 0;
+};
+
+#endif //COMPRESSION_CPP_NODEPOOL_H
@@ -1,6 +1,10 @@
 #ifndef STRING_PROCESSING_CPP_SHORTBITSET_H
 #define STRING_PROCESSING_CPP_SHORTBITSET_H
 
+#include <cstdint>
+#include <cstddef>
+#include <stdexcept>
+
 // Bit set that can store 0 to 32 bits
 class ShortBitSet {
 public:
@@ -33,6 +37,12 @@ public:
         return data & (1 << (numBits -1 - index));
     }
 
+    // return all bits as integer, with index=0 being the MSB of the lowest size() bits
+    [[nodiscard]]
+    uint32_t value() const {
+        return data;
+    }
+
     [[nodiscard]]
     uint8_t size() const {
         return numBits;
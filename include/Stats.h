@@ -0,0 +1,194 @@
+#ifndef COMPRESSION_CPP_STATS_H
+#define COMPRESSION_CPP_STATS_H
+
+#include <ostream>
+#include <iomanip>
+#include <string>
+#include <string_view>
+#include <map>
+#include <array>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <algorithm>
+#include <cstdint>
+
+// Statistics of the stages of the codecs: wall time, bytes in and out and the byte histogram of the uncompressed
+// data, from which its entropy is computed. Stages are instrumented with the STATS_* macros, which only record
+// something if COMPRESSION_STATS is defined when the header is included and do not even evaluate their arguments
+// otherwise. Recording also has to be enabled at runtime; each stage is a whole block or buffer, so an enabled
+// build costs one flag check per stage and block while recording is off.
+// Stages named "a.b" are part of stage "a"; the times of stages that run on several threads are summed up.
+// Stages on 16 bit symbols, like zero_run and huffman in BWMH, count each symbol as 2 bytes.
+// The functions are inline, so that all translation units of a program record into the same registry.
+namespace stats {
+    using Clock = std::chrono::steady_clock;
+
+    struct Stage {
+        size_t calls = 0;
+        double seconds = 0;
+        uint64_t bytesIn = 0;
+        uint64_t bytesOut = 0;
+    };
+
+    namespace internal {
+        struct Registry {
+            std::atomic<bool> enabled{false};
+            std::mutex mutex;
+            std::map<std::string, Stage> stages; // sorted by name, so parts follow their stage
+            std::array<uint64_t, 256> histogram{};
+        };
+
+        inline Registry& registry() {
+            static Registry registry;
+            return registry;
+        }
+    }
+
+    // start or stop recording
+    inline void enable(const bool enabled = true) {
+        internal::registry().enabled.store(enabled, std::memory_order_relaxed);
+    }
+
+    inline bool enabled() {
+        return internal::registry().enabled.load(std::memory_order_relaxed);
+    }
+
+    // add a call of a stage
+    inline void record(const std::string_view name, const double seconds, const uint64_t bytesIn,
+                       const uint64_t bytesOut) {
+        internal::Registry& registry = internal::registry();
+        const std::lock_guard<std::mutex> lock(registry.mutex);
+        Stage& stage = registry.stages[std::string(name)];
+        ++stage.calls;
+        stage.seconds += seconds;
+        stage.bytesIn += bytesIn;
+        stage.bytesOut += bytesOut;
+    }
+
+    // add the bytes of uncompressed data to the histogram
+    inline void count(const std::string_view data) {
+        if (!enabled()) return;
+        std::array<uint64_t, 256> counts{};
+        for (const char c : data) ++counts[static_cast<uint8_t>(c)];
+        internal::Registry& registry = internal::registry();
+        const std::lock_guard<std::mutex> lock(registry.mutex);
+        for (size_t c = 0; c < counts.size(); ++c) registry.histogram[c] += counts[c];
+    }
+
+    // recorded stages by name
+    inline std::map<std::string, Stage> stages() {
+        internal::Registry& registry = internal::registry();
+        const std::lock_guard<std::mutex> lock(registry.mutex);
+        return registry.stages;
+    }
+
+    // number of bytes of uncompressed data that were counted
+    inline uint64_t numCounted() {
+        internal::Registry& registry = internal::registry();
+        const std::lock_guard<std::mutex> lock(registry.mutex);
+        uint64_t total = 0;
+        for (const uint64_t n : registry.histogram) total += n;
+        return total;
+    }
+
+    // order-0 entropy of the counted data in bits per byte
+    inline double entropy() {
+        internal::Registry& registry = internal::registry();
+        const std::lock_guard<std::mutex> lock(registry.mutex);
+        uint64_t total = 0;
+        for (const uint64_t n : registry.histogram) total += n;
+        double bits = 0;
+        for (const uint64_t n : registry.histogram) {
+            if (n == 0) continue;
+            const double p = static_cast<double>(n) / static_cast<double>(total);
+            bits -= p * std::log2(p);
+        }
+        return bits;
+    }
+
+    // clear all recorded data
+    inline void reset() {
+        internal::Registry& registry = internal::registry();
+        const std::lock_guard<std::mutex> lock(registry.mutex);
+        registry.stages.clear();
+        registry.histogram.fill(0);
+    }
+
+    // print the stages as table, with the throughput of the uncompressed side (the larger of bytes in and out)
+    inline void report(std::ostream& os) {
+        const auto flags = os.flags();
+        os << std::left << std::setw(20) << "stage" << std::right << std::setw(8) << "calls" << std::setw(12)
+           << "time ms" << std::setw(14) << "bytes in" << std::setw(14) << "bytes out" << std::setw(10) << "MB/s\n";
+        os << std::fixed << std::setprecision(1);
+        const std::map<std::string, Stage> recorded = stages();
+        for (const auto& [name, stage] : recorded) {
+            // parts are indented below their stage, if it was recorded
+            const size_t dot = name.rfind('.');
+            const bool isPart = dot != std::string::npos && recorded.count(name.substr(0, dot)) > 0;
+            os << std::left << std::setw(20) << (isPart ? "  " : "") + name << std::right
+               << std::setw(8) << stage.calls << std::setw(12) << 1000 * stage.seconds
+               << std::setw(14) << stage.bytesIn << std::setw(14) << stage.bytesOut << std::setw(9)
+               << (stage.seconds > 0 ? static_cast<double>(std::max(stage.bytesIn, stage.bytesOut)) / 1e6 / stage.seconds
+                                     : 0) << "\n";
+        }
+        const double bitsPerByte = entropy();
+        const uint64_t numBytes = numCounted();
+        os << std::setprecision(3) << "Entropy of the " << numBytes << " uncompressed bytes: " << bitsPerByte
+           << " bits per byte, an order-0 coder needs at least "
+           << static_cast<uint64_t>(std::ceil(bitsPerByte * static_cast<double>(numBytes) / 8)) << " bytes\n";
+        os.flags(flags);
+    }
+
+    // records the time from its construction to its destruction as a call of a stage, if recording is enabled
+    class Timer {
+    public:
+        Timer(const char* name, const uint64_t bytesIn) : name{name}, bytesIn{bytesIn}, active{enabled()} {
+            if (active) start = Clock::now();
+        }
+        Timer(const Timer& rhs) = delete;
+        Timer& operator=(const Timer& rhs) = delete;
+
+        ~Timer() {
+            stop();
+        }
+
+        // record the call now instead of at the end of the scope
+        void stop() {
+            if (!active) return;
+            active = false;
+            const std::chrono::duration<double> elapsed = Clock::now() - start;
+            record(name, elapsed.count(), bytesIn, bytesOut);
+        }
+
+        void output(const uint64_t numBytes) {
+            bytesOut = numBytes;
+        }
+
+    private:
+        const char* name;
+        uint64_t bytesIn;
+        uint64_t bytesOut = 0;
+        bool active;
+        Clock::time_point start;
+    };
+} // stats
+
+#ifdef COMPRESSION_STATS
+// time the rest of the enclosing scope as stage name, which reads bytesIn bytes
+#define STATS_STAGE(timer, name, bytesIn) ::stats::Timer timer((name), (bytesIn))
+// set the number of bytes written by the stage of timer
+#define STATS_OUTPUT(timer, bytesOut) (timer).output(bytesOut)
+// end the stage of timer before the end of its scope
+#define STATS_STOP(timer) (timer).stop()
+// add uncompressed data to the histogram
+#define STATS_COUNT(data) ::stats::count(data)
+#else
+#define STATS_STAGE(timer, name, bytesIn) ((void) 0)
+#define STATS_OUTPUT(timer, bytesOut) ((void) 0)
+#define STATS_STOP(timer) ((void) 0)
+#define STATS_COUNT(data) ((void) 0)
+#endif
+
+#endif //COMPRESSION_CPP_STATS_H
@@ -0,0 +1,74 @@
+#ifndef COMPRESSION_CPP_THREADPOOL_H
+#define COMPRESSION_CPP_THREADPOOL_H
+
+#include <vector>
+#include <queue>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <memory>
+#include <type_traits>
+
+// Fixed number of worker threads that execute submitted tasks in FIFO order
+class ThreadPool {
+public:
+    explicit ThreadPool(const size_t numThreads) {
+        for (size_t i = 0; i < numThreads; ++i) {
+            workers.emplace_back([this] { work(); });
+        }
+    }
+    ThreadPool() = delete;
+    ThreadPool(ThreadPool&& rhs) = delete;
+    ThreadPool(const ThreadPool& rhs) = delete;
+    ThreadPool& operator=(const ThreadPool& rhs) = delete;
+
+    // schedule f for execution, exceptions thrown by f are rethrown by the returned future
+    template<typename F>
+    std::future<std::invoke_result_t<F>> submit(F&& f) {
+        // std::function requires copyable targets, so the packaged_task has to be shared
+        auto task = std::make_shared<std::packaged_task<std::invoke_result_t<F>()>>(std::forward<F>(f));
+        auto result = task->get_future();
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            tasks.emplace([task] { (*task)(); });
+        }
+        cv.notify_one();
+        return result;
+    }
+
+    // finish all submitted tasks, then join the workers
+    ~ThreadPool() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        cv.notify_all();
+        for (auto& worker : workers) {
+            worker.join();
+        }
+    }
+private:
+    std::vector<std::thread> workers;
+    std::queue<std::function<void()>> tasks;
+    std::mutex mutex;
+    std::condition_variable cv;
+    bool stopping = false;
+
+    void work() {
+        while (true) {
+            std::function<void()> task;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                cv.wait(lock, [this] { return stopping || !tasks.empty(); });
+                if (tasks.empty()) return; // stopping and nothing left to do
+                task = std::move(tasks.front());
+                tasks.pop();
+            }
+            task();
+        }
+    }
+};
+
+#endif //COMPRESSION_CPP_THREADPOOL_H
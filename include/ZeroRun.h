@@ -0,0 +1,91 @@
+#ifndef COMPRESSION_CPP_ZERORUN_H
+#define COMPRESSION_CPP_ZERORUN_H
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <limits>
+#include <stdexcept>
+#include <cstdint>
+#include "Stats.h"
+
+// Run-length encoding of zeros as in bzip2, applied to the output of the move-to-front transform, which mostly
+// consists of runs of zeros. The length of a run is written in bijective base 2 with the digits RUNA (1) and
+// RUNB (2), least significant digit first, so a run of n zeros needs about log2(n) symbols. All other bytes are
+// shifted by one, which extends the alphabet to 257 symbols.
+namespace zero_run {
+    constexpr static uint16_t RUNA = 0;
+    constexpr static uint16_t RUNB = 1;
+    constexpr static size_t numSymbols = 257; // RUNA, RUNB and the bytes 1 to 255
+
+    namespace internal {
+        // append the symbols for a run of length zeros
+        [[maybe_unused]]
+        static void writeRun(std::vector<uint16_t>& output, size_t length) {
+            while (length > 0) {
+                if (length & 1) {
+                    output.push_back(RUNA);
+                    length = (length - 1) / 2;
+                } else {
+                    output.push_back(RUNB);
+                    length = (length - 2) / 2;
+                }
+            }
+        }
+    }
+
+    // replace the runs of zeros in the input by RUNA/RUNB symbols
+    [[maybe_unused]]
+    static std::vector<uint16_t> encode(const std::string_view input) {
+        STATS_STAGE(timer, "zero_run", input.size());
+        std::vector<uint16_t> output;
+        output.reserve(input.size());
+        size_t run = 0;
+        for (const char ch : input) {
+            const auto c = static_cast<uint8_t>(ch);
+            if (c == 0) {
+                ++run;
+                continue;
+            }
+            internal::writeRun(output, run);
+            run = 0;
+            output.push_back(static_cast<uint16_t>(c + 1));
+        }
+        internal::writeRun(output, run);
+        STATS_OUTPUT(timer, 2 * output.size());
+        return output;
+    }
+
+    // expand symbols that were created with encode
+    // @param maxSize largest valid size of the output, a run that would exceed it is rejected before it is appended
+    [[maybe_unused]]
+    static std::string decode(const std::vector<uint16_t>& symbols, const size_t maxSize) {
+        STATS_STAGE(timer, "zero_run", 2 * symbols.size());
+        std::string output;
+        output.reserve(symbols.size());
+        size_t run = 0;
+        size_t weight = 1; // value of the next digit
+        for (const uint16_t symbol : symbols) {
+            if (symbol <= RUNB) {
+                if (weight > std::numeric_limits<size_t>::max() / 4
+                    || run + (weight << symbol) > maxSize - output.size()) {
+                    throw std::runtime_error("Invalid zero run");
+                }
+                run += weight << symbol; // RUNA adds weight, RUNB twice the weight
+                weight <<= 1;
+                continue;
+            }
+            if (symbol >= numSymbols) throw std::runtime_error("Invalid zero run symbol");
+            if (output.size() + run == maxSize) throw std::runtime_error("Zero run output too large");
+            output.append(run, '\0');
+            run = 0;
+            weight = 1;
+            output.push_back(static_cast<char>(symbol - 1));
+        }
+        output.append(run, '\0');
+        STATS_OUTPUT(timer, output.size());
+        return output;
+    }
+} // zero_run
+
+#endif //COMPRESSION_CPP_ZERORUN_H
@@ -4,34 +4,34 @@
 #define STRING_PROCESSING_CPP_TERNARYSEARCHTRIE_H
 
 #include <optional>
-#include <memory>
 #include <string_view>
+#include "NodePool.h"
 
+// nodes are allocated from a pool owned by the trie, so they are released at once
 template<typename Value>
 class TernarySearchTrie {
 private:
-    struct Node;
-    using NodeUPtr = std::unique_ptr<Node>;
     struct Node {
         std::optional<Value> value;
         char c = '\0';
-        NodeUPtr left, mid, right;
+        Node *left = nullptr, *mid = nullptr, *right = nullptr;
     };
 
-    NodeUPtr root;
+    NodePool<Node> pool;
+    Node* root = nullptr;
 
-    NodeUPtr put(NodeUPtr x, const std::string_view key, const size_t depth, const Value value) {
+    Node* put(Node* x, const std::string_view key, const size_t depth, const Value value) {
         const char c = key[depth];
         if (!x) {
-            x = std::make_unique<Node>();
+            x = pool.create();
             x->c = c;
         }
         if (c < x->c) {
-            x->left = put(std::move(x->left), key, depth, value);
+            x->left = put(x->left, key, depth, value);
         } else if (c > x->c) {
-            x->right = put(std::move(x->right), key, depth, value);
+            x->right = put(x->right, key, depth, value);
         } else if (depth < key.size()-1) {
-            x->mid = put(std::move(x->mid), key, depth+1, value);
+            x->mid = put(x->mid, key, depth+1, value);
         } else {
             x->value = value;
         }
@@ -42,11 +42,11 @@ private:
         if (!x) return x;
         const char c = key[depth];
         if (c < x->c) {
-            return get(x->left.get(), key, depth);
+            return get(x->left, key, depth);
         } else if (c > x->c) {
-            return get(x->right.get(), key, depth);
+            return get(x->right, key, depth);
         } else if (depth < key.size()-1) {
-            return get(x->mid.get(), key, depth+1);
+            return get(x->mid, key, depth+1);
         } else {
             return x;
         }
@@ -58,23 +58,32 @@ private:
         const char c = key[depth];
 
         if (c < x->c) {
-            return search(x->left.get(), key, depth, length);
+            return search(x->left, key, depth, length);
         } else if (c > x->c) {
-            return search(x->right.get(), key, depth, length);
+            return search(x->right, key, depth, length);
         } else {
             // character matches! go down middle
             if (x->value) length = depth+1;
-            return search(x->mid.get(), key, depth+1, length);
+            return search(x->mid, key, depth+1, length);
         }
     }
 public:
+    // @param initialCapacity number of nodes that can be added before the pool needs to grow
+    explicit TernarySearchTrie(const size_t initialCapacity = 64) : pool(initialCapacity) {}
+
     void put(const std::string_view key, const Value value) {
-        root = put(std::move(root), key, 0, value);
+        root = put(root, key, 0, value);
+    }
+
+    // remove all keys, the memory of the nodes is kept for new keys
+    void clear() {
+        pool.clear();
+        root = nullptr;
     }
 
     [[nodiscard]]
     std::optional<Value> get(const std::string_view key) const {
-        Node* x = get(root.get(), key, 0);
+        Node* x = get(root, key, 0);
         if (!x) return {};
         return x->value;
     }
@@ -86,7 +95,7 @@ public:
 
     [[nodiscard]]
     std::string_view longestPrefixOf(std::string_view key) const {
-        const int length = search(root.get(), key,0, 0);
+        const int length = search(root, key,0, 0);
         return key.substr(0, length);
     }
 };
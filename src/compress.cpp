@@ -1,11 +1,77 @@
 #include <iostream>
 #include <fstream>
+#include <thread>
+#include <memory>
+#include <optional>
+#include <chrono>
+#include <filesystem>
 #include "Huffman.h"
 #include "LZW.h"
 #include "BurrowsWheeler.h"
 #include "MoveToFront.h"
+#include "BWMH.h"
+#include "BlockStream.h"
+#include "MappedFile.h"
+#include "MemoryStreamBuf.h"
+#include "Stats.h"
 #include "external/argagg.h"
 
+// a compression method applied to independent blocks
+struct Codec {
+    block::CodecId id;
+    std::string description;
+    std::string extension;
+    block::BlockCodec compressBlock;
+    std::function<std::string(const std::string&, uint8_t)> expandBlock; // format depends on block stream version
+    std::function<void(std::istream&, std::ostream&)> expandLegacy; // for files without block stream header
+};
+
+constexpr static size_t outputBufferSize = size_t{16} << 20; // 16 MiB
+
+// parse a size in bytes with an optional suffix k/K (KiB), m/M (MiB) or g/G (GiB)
+static size_t parseSize(const std::string& str) {
+    size_t pos = 0;
+    const unsigned long long val = std::stoull(str, &pos);
+    const std::string suffix = str.substr(pos);
+    int shift;
+    if (suffix.empty()) shift = 0;
+    else if (suffix == "k" || suffix == "K") shift = 10;
+    else if (suffix == "m" || suffix == "M") shift = 20;
+    else if (suffix == "g" || suffix == "G") shift = 30;
+    else throw std::invalid_argument("Invalid size suffix: " + suffix);
+    if (val > (std::numeric_limits<size_t>::max() >> shift)) throw std::out_of_range("Size too large: " + str);
+    return val << shift;
+}
+
+// all codecs are applied to independent blocks; files without block stream header are from older versions
+static Codec makeCodec(const block::CodecId id, const size_t lzwBits) {
+    switch (id) {
+        case block::CodecId::LZW:
+            return {id, "LZW compression", ".lzw",
+                    [lzwBits](const std::string& in) { return lzw::compress(in, lzw::Format::Variable, lzwBits); },
+                    [](const std::string& in, uint8_t) { return lzw::expand(in); },
+                    [](std::istream& is, std::ostream& os) { lzw::expand(is, os); }};
+        case block::CodecId::BWMH:
+            return {id, "Burrows-Wheeler, move-to-front, Huffman compression", ".bwmh",
+                    bwmh::compressBlock,
+                    bwmh::expandBlock,
+                    [](std::istream& is, std::ostream& os) {
+                        // older versions compressed the whole input as a single block
+                        const std::string input(std::istreambuf_iterator<char>(is), {});
+                        const std::string output = bwmh::expandBlock(input, 1);
+                        os.write(output.data(), static_cast<std::streamsize>(output.size()));
+                    }};
+        default:
+            return {block::CodecId::Huffman, "Huffman compression", ".huffman",
+                    [](const std::string& in) { return huffman::compress(in, huffman::Format::Canonical); },
+                    [](const std::string& in, const uint8_t version) {
+                        return huffman::expand(in, version >= 2 ? huffman::Format::Canonical
+                                                                : huffman::Format::Trie);
+                    },
+                    [](std::istream& is, std::ostream& os) { huffman::expand(is, os, huffman::Format::Trie); }};
+    }
+}
+
 int main(int argc, char** argv) {
     // Parse arguments
     argagg::parser argparser{{
@@ -13,6 +79,13 @@ int main(int argc, char** argv) {
                                      {"lzw", {"-l", "--lzw"}, "Use LZW compression instead of Huffman", 0},
                                      {"bwmh", {"-b", "--bwmh"}, "Use Burrows-Wheeler, move-to-front, and then Huffman compression instead of only Huffman", 0},
                                      {"extract", {"-x", "--extract"}, "Extract input file instead of compressing it", 0},
+                                     {"block-size", {"-B", "--block-size"}, "Size of independently compressed blocks (default: 1M)", 1},
+                                     {"threads", {"-T", "--threads"}, "Number of threads for compressing or extracting blocks in parallel (default: 1, 0: all cores)", 1},
+                                     {"lzw-bits", {"-W", "--lzw-bits"}, "Maximum width of LZW codes in bits (9 to 24, default: 16)", 1},
+                                     {"no-mmap", {"--no-mmap"}, "Read the input file with a stream instead of mapping it into memory", 0},
+                                     {"range", {"--range"}, "Extract only LEN bytes starting at OFFSET of the original file (OFFSET:LEN, both with optional suffix k/M/G)", 1},
+                                     {"no-verify", {"--no-verify"}, "Do not check the checksums of the blocks when extracting (their sizes are still checked)", 0},
+                                     {"stats", {"--stats"}, "Print the time, bytes and throughput of each stage and the entropy of the data", 0},
                              }};
     argagg::parser_results args;
     try {
@@ -29,123 +102,166 @@ int main(int argc, char** argv) {
         fmt << "\nExamples:\n";
         fmt << program << " input.txt\t\tCompress input.txt with Huffman\n";
         fmt << program << " -l input.txt\t\tCompress input.txt with LZW\n";
-        fmt << program << " -xl input.txt.lzw\tExtract input.txt.lzw with LZW\n";
+        fmt << program << " -x input.txt.lzw\tExtract input.txt.lzw, the codec is detected\n";
+        fmt << program << " -b -B 64M input.txt\tCompress with BWMH in 64 MiB blocks\n";
+        fmt << program << " -T 8 input.txt\t\tCompress input.txt with Huffman on 8 threads\n";
+        fmt << program << " -x --range 1M:4k input.txt.bwmh\tExtract 4 KiB at 1 MiB\n";
+        fmt << program << " -b --stats input.txt\tPrint statistics of the BWMH stages\n";
         return 1;
     }
 
-    const std::string file_in = args.pos[0];
-
-
-    if (args.options["lzw"]) {
-        std::cout << "Using LZW compression...\n";
-
-        if (args.options["extract"]) {
-            const std::string file_out = file_in + ".orig";
-            std::cout << "Extracting " << file_in << " to " << file_out << "\n";
-
-            std::ifstream ifs(file_in);
-            std::ofstream ofs(file_out);
-
-            if (!ifs || !ofs) {
-                std::cerr << "Error opening input or output file.\n";
-                return 1;
-            }
-
-            lzw::expand(ifs, ofs);
-        } else {
-            // compress
-            const std::string file_out = file_in + ".lzw";
-
-            std::cout << "Compressing " << file_in << " to " << file_out << "\n";
-
-            std::ifstream ifs(file_in);
-            std::ofstream ofs(file_out);
+#ifndef COMPRESSION_STATS
+    if (args["stats"]) {
+        std::cerr << "Statistics are not available, build with COMPRESSION_STATS.\n";
+        return 1;
+    }
+#endif
+    const bool printStats = args["stats"];
+    stats::enable(printStats);
+    const auto start = std::chrono::steady_clock::now();
 
-            if (!ifs || !ofs) {
-                std::cerr << "Error opening input or output file.\n";
-                return 1;
-            }
+    const std::string file_in = args.pos[0];
 
-            lzw::compress(ifs, ofs);
+    size_t blockSize = bwmh::defaultBlockSize; // also used for the other codecs
+    if (args["block-size"]) {
+        try {
+            blockSize = parseSize(args["block-size"].as<std::string>());
+        } catch (const std::exception&) {
+            blockSize = 0;
         }
-    } else if (args.options["bwmh"]) {
-        std::cout << "Using Burrows-Wheeler, move-to-front, Huffman compression...\n";
-
-        if (args.options["extract"]) {
-            const std::string file_out = file_in+".orig";
-            std::cout<<"Extracting "<<file_in<<" to "<<file_out<<"\n";
-
-            std::ifstream ifs(file_in);
-            std::ofstream ofs(file_out);
-
-            if (!ifs || !ofs) {
-                std::cerr << "Error opening input or output file.\n";
-                return 1;
-            }
-
-            std::stringstream post_huffman;
-            huffman::expand(ifs, post_huffman);
-
-            std::stringstream post_rmtf;
-            mtf::decode(post_huffman, post_rmtf);
-
-            bw::decode(post_rmtf, ofs);
-        } else {
-            // compress
-            const std::string file_out = file_in+".bwmh";
-            std::cout<<"Compressing "<<file_in<<" to "<<file_out<<"\n";
-
-            std::ifstream ifs(file_in);
-            std::ofstream ofs(file_out);
-
-            if (!ifs|| !ofs) {
-                std::cerr << "Error opening input or output file.\n";
-                return 1;
-            }
-
-            std::cout << "WARNING: this Burrows-Wheeler implementation is very slow in some cases!\n";
-
-            std::stringstream post_bw;
-            bw::encode(ifs, post_bw);
+        if (blockSize == 0 || blockSize > block::maxBlockSize) {
+            std::cerr << "Invalid block size, must be between 1 and 1G.\n";
+            return 1;
+        }
+    }
 
-            std::stringstream post_mtf;
-            mtf::encode(post_bw, post_mtf);
+    size_t numThreads = 1;
+    if (args["threads"]) {
+        try {
+            numThreads = args["threads"].as<size_t>();
+        } catch (const std::exception&) {
+            std::cerr << "Invalid number of threads.\n";
+            return 1;
+        }
+        if (numThreads == 0) numThreads = std::max(1u, std::thread::hardware_concurrency());
+    }
 
-            std::stringstream post_mtf2(post_mtf.str()); // copy
+    size_t lzwBits = lzw::defaultMaxWidth;
+    if (args["lzw-bits"]) {
+        try {
+            lzwBits = args["lzw-bits"].as<size_t>();
+        } catch (const std::exception&) {
+            lzwBits = 0;
+        }
+        if (lzwBits < lzw::minWidth || lzwBits > lzw::maxMaxWidth) {
+            std::cerr << "Invalid LZW code width, must be between 9 and 24.\n";
+            return 1;
+        }
+    }
 
-            huffman::compress(post_mtf, post_mtf2, ofs);}
-    } else {
-        std::cout << "Using Huffman compression...\n";
+    // only the blocks that contain the range are expanded
+    std::optional<std::pair<uint64_t, uint64_t>> range;
+    if (args["range"]) {
+        const std::string str = args["range"].as<std::string>();
+        const size_t colon = str.find(':');
+        try {
+            if (colon == std::string::npos) throw std::invalid_argument("Missing length");
+            range = {parseSize(str.substr(0, colon)), parseSize(str.substr(colon + 1))};
+        } catch (const std::exception&) {
+            std::cerr << "Invalid range, must be OFFSET:LEN.\n";
+            return 1;
+        }
+        if (!args["extract"]) {
+            std::cerr << "A range can only be given for extracting.\n";
+            return 1;
+        }
+    }
 
-        if (args.options["extract"]) {
-            const std::string file_out = file_in+".orig";
-            std::cout<<"Extracting "<<file_in<<" to "<<file_out<<"\n";
+    // framed streams name their codec, so it only needs to be given for compressing and for older streams
+    const block::CodecId codecId = args.options["lzw"] ? block::CodecId::LZW
+                                   : args.options["bwmh"] ? block::CodecId::BWMH : block::CodecId::Huffman;
+    Codec codec = makeCodec(codecId, lzwBits);
+
+    const bool extract = args.options["extract"];
+    const bool verify = !args["no-verify"];
+    const std::string file_out = file_in + (extract ? ".orig" : codec.extension);
+    std::cout << (extract ? "Extracting " : "Compressing ") << file_in << " to " << file_out << "\n";
+
+    // the input is mapped into memory if possible, so reading it needs no system call per chunk
+    const bool useMmap = !args["no-mmap"];
+    std::unique_ptr<MappedFile> mapped;
+    if (useMmap) {
+        try {
+            mapped = std::make_unique<MappedFile>(file_in);
+        } catch (const std::exception&) {
+            // e.g. pipes cannot be mapped, read them as stream
+        }
+    }
+    std::ifstream ifs;
+    if (!mapped) ifs.open(file_in, std::ios::binary);
+    MemoryStreamBuf mappedBuf(mapped ? mapped->view() : std::string_view());
+    std::istream is(mapped ? static_cast<std::streambuf*>(&mappedBuf) : ifs.rdbuf());
+
+    // the output is collected in a large buffer, which has to be set before opening the file
+    std::vector<char> outputBuffer;
+    std::ofstream ofs;
+    if (useMmap) {
+        outputBuffer.resize(outputBufferSize);
+        ofs.rdbuf()->pubsetbuf(outputBuffer.data(), static_cast<std::streamsize>(outputBuffer.size()));
+    }
+    ofs.open(file_out, std::ios::binary);
 
-            std::ifstream ifs(file_in);
-            std::ofstream ofs(file_out);
+    if ((!mapped && !ifs) || !ofs) {
+        std::cerr << "Error opening input or output file.\n";
+        return 1;
+    }
 
-            if (!ifs || !ofs) {
-                std::cerr << "Error opening input or output file.\n";
-                return 1;
+    // errors, e.g. of corrupted input, leave no partial output behind
+    try {
+        if (extract) {
+            const block::Header header = block::readHeader(is);
+            if (header.codec != block::CodecId::None) codec = makeCodec(header.codec, lzwBits);
+            std::cout << "Using " << codec.description << "...\n";
+            auto expandBlock = [&codec, &header](const std::string& in) {
+                return codec.expandBlock(in, header.version);
+            };
+            if (range) {
+                if (header.version < block::firstFramedVersion) {
+                    throw std::runtime_error("A range can only be extracted from files with block index");
+                }
+                is.seekg(0);
+                const block::Index index = block::readIndex(is);
+                block::expandRange(is, ofs, index, range->first, range->second, expandBlock, numThreads, verify);
+            } else if (header) {
+                block::expandBlocks(is, ofs, header, expandBlock, numThreads, verify);
+            } else {
+                codec.expandLegacy(is, ofs);
             }
-
-            huffman::expand(ifs, ofs);
         } else {
-            // compress
-            const std::string file_out = file_in+".huffman";
-            std::cout<<"Compressing "<<file_in<<" to "<<file_out<<"\n";
-
-            std::ifstream ifs1(file_in);
-            std::ifstream ifs2(file_in);
-            std::ofstream ofs(file_out);
-
-            if (!ifs1 || !ifs2 || !ofs) {
-                std::cerr << "Error opening input or output file.\n";
-                return 1;
-            }
-
-            huffman::compress(ifs1, ifs2, ofs);
+            std::cout << "Using " << codec.description << "...\n";
+            block::compress(is, ofs, blockSize, codec.compressBlock, numThreads, codec.id);
         }
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << "\n";
+        ofs.close();
+        std::error_code error;
+        std::filesystem::remove(file_out, error);
+        return 1;
+    }
+
+    if (printStats) {
+        ofs.flush();
+        const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        std::error_code error;
+        const auto sizeIn = std::filesystem::file_size(file_in, error);
+        const auto sizeOut = static_cast<uint64_t>(ofs.tellp());
+        std::cout << "\nStatistics" << (numThreads > 1 ? " (times of stages on several threads are summed up)" : "")
+                  << ":\n";
+        stats::report(std::cout);
+        std::cout << "Total: " << std::fixed << std::setprecision(1) << 1000 * elapsed.count() << " ms, "
+                  << (error ? 0 : sizeIn) << " bytes in, " << sizeOut << " bytes out, "
+                  << static_cast<double>(std::max<uint64_t>(error ? 0 : sizeIn, sizeOut)) / 1e6 / elapsed.count()
+                  << " MB/s\n";
     }
 
     return 0;
@@ -88,4 +88,35 @@ TEST(bitstreamin, readShortBitSet) { // NOLINT
         }
         EXPECT_EQ(bs.at(31), true);
     }
-}
\ No newline at end of file
+}
+
+TEST(bitstreamin, peekAndConsume) { // NOLINT
+    std::istringstream iss({'\xa5', '\x0f', '\x81'}, std::ios::binary);
+    BitStreamIn bsi(iss);
+    EXPECT_EQ(bsi.peekBits(0), 0);
+    EXPECT_EQ(bsi.peekBits(4), 0xa);
+    EXPECT_EQ(bsi.peekBits(12), 0xa50);
+    bsi.consumeBits(4);
+    EXPECT_EQ(bsi.readBits(8), 0x50);
+    EXPECT_EQ(bsi.peekBits(32), 0xf8100000); // padded with zeros after end of stream
+    EXPECT_EQ(bsi.readBits(12), 0xf81);
+    EXPECT_EQ(bsi.peekBits(8), 0);
+    EXPECT_ANY_THROW(bsi.consumeBits(1));
+    EXPECT_ANY_THROW(bsi.readBits(1));
+}
+
+TEST(bitstreamin, largeInput) { // NOLINT
+    // more than one internal buffer with reads that are not aligned to bytes
+    std::string data;
+    for (size_t i=0; i < 3 * BitStreamIn::bufferSize + 5; ++i) {
+        data.push_back(static_cast<char>(i * 7 + i / 256));
+    }
+    std::istringstream iss(data, std::ios::binary);
+    BitStreamIn bsi(iss);
+    for (size_t i=0; i < data.size(); ++i) {
+        const auto byte = static_cast<uint8_t>(data[i]);
+        EXPECT_EQ(bsi.readBits(3), byte >> 5);
+        EXPECT_EQ(bsi.readBits(5), byte & 0x1f);
+    }
+    EXPECT_ANY_THROW(bsi.skip(1));
+}
@@ -89,4 +89,49 @@ TEST(bitstreamout, writeShortBitSet) { // NOLINT
         EXPECT_EQ(static_cast<uint8_t>(res[0]), 0b11100101);
         EXPECT_EQ(static_cast<uint8_t>(res[1]), 0b11000000);
     }
-}
\ No newline at end of file
+}
+
+TEST(bitstreamout, writeBits) { // NOLINT
+    std::ostringstream ss;
+    {
+        BitStreamOut bso(ss);
+        bso.writeBits(0b101, 3);
+        bso.writeBits(0xffffffff, 32);
+        bso.writeBits(0, 0);
+        bso.writeBits(0xabcdef01, 8); // only lowest 8 bits
+        bso.writeBits(0b1, 5);
+    }
+    {
+        std::string res = ss.str();
+        EXPECT_EQ(res.size(), 6);
+        EXPECT_EQ(static_cast<uint8_t>(res[0]), 0b10111111);
+        for (size_t i=1; i<4; ++i) {
+            EXPECT_EQ(static_cast<uint8_t>(res[i]), 0xff);
+        }
+        EXPECT_EQ(static_cast<uint8_t>(res[4]), 0b11100000);
+        EXPECT_EQ(static_cast<uint8_t>(res[5]), 0b00100001);
+    }
+}
+
+TEST(bitstreamout, largeOutput) { // NOLINT
+    // more than one internal buffer, compared with writing single bits
+    std::ostringstream ssBits;
+    std::ostringstream ssInts;
+    {
+        BitStreamOut bsoBits(ssBits);
+        BitStreamOut bsoInts(ssInts);
+        for (uint32_t i=0; i < 100000; ++i) {
+            const size_t len = 1 + i % 32;
+            for (size_t j=len; j-- > 0;) {
+                bsoBits.write(static_cast<bool>((i >> j) & 1));
+            }
+            bsoInts.writeInteger(i, len);
+        }
+        // nothing may be missing after flush
+        bsoBits.flush();
+        bsoInts.flush();
+        EXPECT_EQ(ssBits.str(), ssInts.str());
+    }
+    EXPECT_EQ(ssBits.str(), ssInts.str());
+    EXPECT_GT(ssInts.str().size(), BitStreamOut::bufferSize);
+}
@@ -0,0 +1,224 @@
+#include <gtest/gtest.h>
+#include <sstream>
+#include <string>
+
+#include "BlockStream.h"
+#include "CRC32C.h"
+
+
+namespace {
+    std::string reverse(const std::string& in) {
+        return {in.rbegin(), in.rend()};
+    }
+
+    std::string compressReversed(const std::string& input, const size_t blockSize, const size_t numThreads = 1) {
+        std::istringstream iss(input);
+        std::ostringstream oss;
+        block::compress(iss, oss, blockSize, reverse, numThreads, block::CodecId::LZW);
+        return oss.str();
+    }
+
+    std::string expandReversed(const std::string& compressed, const size_t numThreads = 1, const bool verify = true) {
+        std::istringstream iss(compressed);
+        std::ostringstream oss;
+        block::expand(iss, oss, [](uint8_t) -> block::BlockCodec { return reverse; }, numThreads, verify);
+        return oss.str();
+    }
+}
+
+TEST(blockStream, crc32c) { // NOLINT
+    EXPECT_EQ(crc32c::compute(""), 0);
+    EXPECT_EQ(crc32c::compute("123456789"), 0xE3069283);
+    EXPECT_EQ(crc32c::extend(crc32c::compute("1234"), "56789"), 0xE3069283);
+
+    // all kernels agree for any length and alignment
+    std::string data;
+    for (int i = 0; i < 300; ++i) data += static_cast<char>(i * 7 + i / 13);
+    const auto* bytes = reinterpret_cast<const uint8_t*>(data.data());
+    for (size_t offset = 0; offset < 9; ++offset) {
+        for (size_t size = 0; offset + size <= data.size(); size += 1 + size / 8) {
+            const uint32_t expected = crc32c::internal::extendBytewise(~0u, bytes + offset, size);
+            EXPECT_EQ(crc32c::internal::extendSlicing8(~0u, bytes + offset, size), expected);
+#ifdef CRC32C_X86_KERNEL
+            if (crc32c::internal::supportsSSE42()) {
+                EXPECT_EQ(crc32c::internal::extendSSE42(~0u, bytes + offset, size), expected);
+            }
+#endif
+            EXPECT_EQ(crc32c::compute(data.substr(offset, size)), ~expected);
+        }
+    }
+    EXPECT_EQ(crc32c::internal::multiply(crc32c::internal::powerOfX(5), crc32c::internal::powerOfX(7)),
+              crc32c::internal::powerOfX(12));
+
+    // large inputs are processed in interleaved stripes
+    std::string large;
+    for (size_t i = 0; i < 7 * crc32c::internal::stripeSize + 5; ++i) large += static_cast<char>((i * i) >> 3);
+    for (const size_t size : {3 * crc32c::internal::stripeSize - 1, 3 * crc32c::internal::stripeSize, large.size()}) {
+        const auto* begin = reinterpret_cast<const uint8_t*>(large.data()) + 1;
+        EXPECT_EQ(~crc32c::compute(std::string_view(large).substr(1, size - 1)),
+                  crc32c::internal::extendBytewise(~0u, begin, size - 1));
+    }
+}
+
+TEST(blockStream, framed) { // NOLINT
+    std::string sOrig;
+    for (int i = 0; i < 1000; ++i) sOrig += "block " + std::to_string(i) + "\n";
+
+    const std::string sComp = compressReversed(sOrig, 1000);
+    EXPECT_EQ(expandReversed(sComp), sOrig);
+    EXPECT_EQ(expandReversed(sComp, 3), sOrig);
+    EXPECT_EQ(expandReversed(compressReversed("", 1000)), "");
+
+    std::istringstream iss(sComp);
+    const block::Header header = block::readHeader(iss);
+    EXPECT_EQ(header.version, block::version);
+    EXPECT_EQ(header.codec, block::CodecId::LZW);
+    EXPECT_EQ(header.blockSize, 1000);
+
+    // the trailer points to the index, whose entries point to the frames
+    std::istringstream trailer(sComp.substr(sComp.size() - block::trailerSize));
+    const uint64_t indexOffset = block::internal::readUInt64(trailer);
+    EXPECT_EQ(block::internal::readUInt64(trailer), sOrig.size());
+    std::istringstream index(sComp.substr(indexOffset));
+    const uint32_t numBlocks = block::internal::readUInt32(index);
+    EXPECT_EQ(numBlocks, (sOrig.size() + 999) / 1000);
+    for (uint32_t i = 0; i < numBlocks; ++i) {
+        const block::IndexEntry entry = block::internal::readIndexEntry(index);
+        EXPECT_EQ(entry.uncompressedOffset, i * 1000);
+        const std::string data = sComp.substr(entry.offset + 12, entry.compressedSize);
+        EXPECT_EQ(reverse(data), sOrig.substr(entry.uncompressedOffset, entry.uncompressedSize));
+        EXPECT_EQ(entry.crc, crc32c::compute(reverse(data)));
+    }
+}
+
+TEST(blockStream, expandingCodec) { // NOLINT
+    // blocks may grow up to the limit that is accepted when reading, larger ones are rejected when writing
+    const std::string sOrig(3000, 'a');
+    const size_t maxSize = block::internal::maxCompressedSize(1000);
+    std::istringstream iss(sOrig);
+    std::ostringstream oss;
+    block::compress(iss, oss, 1000,
+                    [maxSize](const std::string& in) { return in + std::string(maxSize - in.size(), 'x'); });
+    std::istringstream issComp(oss.str());
+    std::ostringstream ossExp;
+    block::expand(issComp, ossExp, [](uint8_t) -> block::BlockCodec {
+        return [](const std::string& in) { return in.substr(0, 1000); };
+    });
+    EXPECT_EQ(ossExp.str(), sOrig);
+
+    std::istringstream issTooLarge(sOrig);
+    std::ostringstream ossTooLarge;
+    EXPECT_THROW(block::compress(issTooLarge, ossTooLarge, 1000,
+                                 [maxSize](const std::string&) { return std::string(maxSize + 1, 'x'); }),
+                 std::runtime_error);
+}
+
+TEST(blockStream, corruption) { // NOLINT
+    std::string sOrig;
+    for (int i = 0; i < 1000; ++i) sOrig += "block " + std::to_string(i) + "\n";
+    const std::string sComp = compressReversed(sOrig, 1000);
+
+    // changed data in a block does not match its checksum
+    std::string corrupted = sComp;
+    corrupted[block::internal::headerSize + 12 + 100] ^= 0x01;
+    EXPECT_THROW(expandReversed(corrupted), std::runtime_error);
+    EXPECT_THROW(expandReversed(corrupted, 4), std::runtime_error);
+    // without verification, only the size is checked
+    EXPECT_EQ(expandReversed(corrupted, 1, false).size(), sOrig.size());
+    EXPECT_NE(expandReversed(corrupted, 2, false), sOrig);
+
+    // errors of the codec name the corrupted block
+    std::istringstream iss(sComp);
+    std::ostringstream oss;
+    try {
+        block::expand(iss, oss, [](uint8_t) -> block::BlockCodec {
+            return [](const std::string&) -> std::string { throw std::runtime_error("Invalid code"); };
+        });
+        FAIL() << "Corrupted block was expanded";
+    } catch (const std::runtime_error& e) {
+        EXPECT_EQ(std::string(e.what()), "Block is corrupted: Invalid code");
+    }
+
+    // the index has to match the blocks
+    corrupted = sComp;
+    corrupted[sComp.size() - block::trailerSize - 1] ^= 0x01;
+    EXPECT_THROW(expandReversed(corrupted), std::runtime_error);
+    EXPECT_THROW(expandReversed(sComp.substr(0, sComp.size() - 1)), std::runtime_error);
+
+    // sizes that do not fit the block size are rejected before the data is read
+    corrupted = sComp;
+    corrupted[block::internal::headerSize] = '\x7F';
+    EXPECT_THROW(expandReversed(corrupted), std::runtime_error);
+    corrupted = sComp;
+    corrupted[block::internal::headerSize + 6] = '\x10';
+    EXPECT_THROW(expandReversed(corrupted), std::runtime_error);
+    corrupted = sComp;
+    corrupted[6] = '\x7F';
+    EXPECT_THROW(expandReversed(corrupted), std::runtime_error);
+
+    // the same holds for the entries of the index
+    std::istringstream trailer(sComp.substr(sComp.size() - block::trailerSize));
+    const uint64_t indexOffset = block::internal::readUInt64(trailer);
+    for (const size_t field : {16, 20}) {
+        corrupted = sComp;
+        corrupted[indexOffset + 4 + field] = '\x7F';
+        std::istringstream issIndex(corrupted);
+        EXPECT_THROW(block::readIndex(issIndex), std::runtime_error);
+    }
+}
+
+TEST(blockStream, olderVersions) { // NOLINT
+    // version 4: header without codec, blocks with only their compressed size
+    const std::string stream = std::string("CCPB\x04", 5) + std::string("\0\0\0\x03" "cba" "\0\0\0\x02" "ed", 13);
+    std::istringstream iss(stream);
+    const block::Header header = block::readHeader(iss);
+    EXPECT_EQ(header.version, 4);
+    EXPECT_EQ(header.codec, block::CodecId::None);
+    EXPECT_EQ(expandReversed(stream), "abcde");
+
+    std::istringstream issFuture(std::string("CCPB\x09", 5));
+    EXPECT_THROW(block::readHeader(issFuture), std::runtime_error);
+}
+
+TEST(blockStream, range) { // NOLINT
+    std::string sOrig;
+    for (int i = 0; i < 1000; ++i) sOrig += "block " + std::to_string(i) + "\n";
+    const std::string sComp = compressReversed(sOrig, 1000);
+
+    std::istringstream iss(sComp);
+    const block::Index index = block::readIndex(iss);
+    EXPECT_EQ(index.header.codec, block::CodecId::LZW);
+    EXPECT_EQ(index.uncompressedSize, sOrig.size());
+    EXPECT_EQ(index.entries.size(), (sOrig.size() + 999) / 1000);
+
+    size_t numExpanded = 0;
+    auto expandRange = [&](const uint64_t offset, const uint64_t length, const size_t numThreads = 1) {
+        std::ostringstream oss;
+        numExpanded = 0;
+        block::expandRange(iss, oss, index, offset, length, [&numExpanded](const std::string& in) {
+            ++numExpanded;
+            return reverse(in);
+        }, numThreads);
+        return oss.str();
+    };
+    for (const uint64_t offset : {0, 1, 999, 1000, 1001, 5555, 9800}) {
+        for (const uint64_t length : {0, 1, 10, 999, 1000, 2500}) {
+            EXPECT_EQ(expandRange(offset, length), sOrig.substr(offset, length));
+        }
+    }
+    // only the blocks that overlap the range are expanded
+    EXPECT_EQ(expandRange(2100, 100), sOrig.substr(2100, 100));
+    EXPECT_EQ(numExpanded, 1);
+    EXPECT_EQ(expandRange(2900, 200, 2), sOrig.substr(2900, 200));
+    EXPECT_EQ(numExpanded, 2);
+    // the range is clamped to the data
+    EXPECT_EQ(expandRange(sOrig.size() - 5, 100), sOrig.substr(sOrig.size() - 5));
+    EXPECT_EQ(expandRange(sOrig.size() + 5, 100), "");
+    EXPECT_EQ(numExpanded, 0);
+
+    // streams of older versions have no index
+    std::istringstream issOld(std::string("CCPB\x04", 5) + std::string("\0\0\0\x01" "a", 5));
+    EXPECT_THROW(block::readIndex(issOld), std::runtime_error);
+    std::istringstream issTruncated(sComp.substr(0, sComp.size() - 3));
+    EXPECT_THROW(block::readIndex(issTruncated), std::runtime_error);
+}
@@ -33,4 +33,20 @@ TEST(bw, encodeAndDecode) { // NOLINT
     encodeAndDecodeFun("*************");
     encodeAndDecodeFun("foobar#§$%&/()=");
     encodeAndDecodeFun("äöü+#``?%$\"!\"§$%€");
-}
\ No newline at end of file
+}
+
+TEST(bw, buffers) { // NOLINT
+    std::string sLong;
+    for (int i = 0; i < 10000; ++i) sLong += static_cast<char>((i * 7) % 13 + (i % 3 == 0 ? 200 : 0));
+    for (const std::string& sOrig : {std::string("ABRACADABRA!"), std::string("a"), sLong}) {
+        std::istringstream iss(sOrig);
+        std::ostringstream oss;
+        bw::encode(iss, oss);
+        const std::string sEnc = bw::encode(sOrig);
+        EXPECT_EQ(sEnc, oss.str());
+        EXPECT_EQ(bw::decode(sEnc), sOrig);
+    }
+    EXPECT_EQ(bw::encode(""), "");
+    EXPECT_ANY_THROW(bw::decode("ab"));
+    EXPECT_ANY_THROW(bw::decode(std::string{0x00, 0x00, 0x00, 0x05, 'a', 'b'})); // index out of range
+}
@@ -0,0 +1,111 @@
+#include <gtest/gtest.h>
+#include <sstream>
+
+#include "BWMH.h"
+
+
+TEST(bwmh, compressAndExpand) { // NOLINT
+    auto compressAndExpandFun = [](const std::string& sOrig, const size_t blockSize) {
+        std::istringstream iss(sOrig);
+        std::ostringstream oss;
+        bwmh::compress(iss, oss, blockSize);
+        const std::string sComp = oss.str();
+
+        iss = std::istringstream(sComp);
+        oss = std::ostringstream();
+        bwmh::expand(iss, oss);
+        EXPECT_EQ(sOrig, oss.str());
+    };
+
+    std::string sLong;
+    for (int i=0; i < 1000; ++i) sLong += "ABRACADABRA! " + std::to_string(i) + "\n";
+
+    for (const size_t blockSize : {1, 7, 1000, 4096, 1 << 20}) {
+        compressAndExpandFun("", blockSize);
+        compressAndExpandFun("ABRACADABRA!", blockSize);
+        compressAndExpandFun("*************", blockSize);
+        compressAndExpandFun(sLong, blockSize);
+    }
+}
+
+TEST(bwmh, blockStreamHeader) { // NOLINT
+    std::istringstream iss("foobar");
+    std::stringstream ss;
+    bwmh::compress(iss, ss, 2);
+    EXPECT_TRUE(block::readHeader(ss));
+
+    std::istringstream issNoHeader("CCP"); // too short
+    EXPECT_FALSE(block::readHeader(issNoHeader));
+    EXPECT_EQ(issNoHeader.tellg(), 0);
+
+    std::istringstream issTruncated(ss.str().substr(0, ss.str().size() - 1));
+    std::ostringstream oss;
+    EXPECT_ANY_THROW(bwmh::expand(issTruncated, oss));
+}
+
+TEST(bwmh, threads) { // NOLINT
+    std::string sOrig;
+    for (int i=0; i < 20000; ++i) sOrig += "line " + std::to_string(i % 97) + " of the log\n";
+
+    auto compressFun = [&sOrig](const size_t numThreads) {
+        std::istringstream iss(sOrig);
+        std::ostringstream oss;
+        bwmh::compress(iss, oss, 4096, numThreads);
+        return oss.str();
+    };
+    const std::string sComp = compressFun(1);
+    for (const size_t numThreads : {2, 3, 8}) {
+        EXPECT_EQ(compressFun(numThreads), sComp); // output must not depend on thread count
+
+        std::istringstream iss(sComp);
+        std::ostringstream oss;
+        bwmh::expand(iss, oss, numThreads);
+        EXPECT_EQ(oss.str(), sOrig);
+    }
+
+    // exceptions in worker threads are passed on
+    std::istringstream iss(sOrig);
+    std::ostringstream oss;
+    auto failing = [](const std::string&) -> std::string { throw std::runtime_error("failed"); };
+    EXPECT_THROW(block::compress(iss, oss, 4096, failing, 4), std::runtime_error);
+}
+
+TEST(bwmh, zeroRuns) { // NOLINT
+    std::string sOrig;
+    for (int i=0; i < 20000; ++i) sOrig += "line " + std::to_string(i % 97) + " of the log\n";
+
+    // blocks of version 2 compressed the move-to-front output directly
+    std::string buf = bw::encode(sOrig);
+    mtf::encode(buf);
+    const std::string sCompV2 = huffman::compress(buf, huffman::Format::Canonical);
+    EXPECT_EQ(bwmh::expandBlock(sCompV2, 2), sOrig);
+
+    // blocks of version 3 used a single Huffman table for the zero-run symbols
+    const std::string sCompV3 = huffman::compressSymbols<zero_run::numSymbols>(zero_run::encode(buf));
+    EXPECT_EQ(bwmh::expandBlock(sCompV3, 3), sOrig);
+    EXPECT_LT(sCompV3.size(), sCompV2.size()); // runs of zeros need less than one bit per byte
+
+    const std::string sComp = bwmh::compressBlock(sOrig);
+    EXPECT_EQ(bwmh::expandBlock(sComp), sOrig);
+    EXPECT_LE(sComp.size(), sCompV3.size() + 1); // number of tables
+
+    const std::string sRun(100000, 'x');
+    EXPECT_LT(bwmh::compressBlock(sRun).size(), 50);
+    EXPECT_EQ(bwmh::expandBlock(bwmh::compressBlock(sRun)), sRun);
+}
+
+TEST(bwmh, range) { // NOLINT
+    std::string sOrig;
+    for (int i=0; i < 20000; ++i) sOrig += "line " + std::to_string(i % 97) + " of the log\n";
+    std::istringstream iss(sOrig);
+    std::stringstream ss;
+    bwmh::compress(iss, ss, 4096);
+
+    for (const auto& [offset, length] : {std::pair<uint64_t, uint64_t>{0, 10}, {4000, 200}, {100000, 12345}}) {
+        std::ostringstream oss;
+        ss.clear();
+        ss.seekg(0);
+        bwmh::expandRange(ss, oss, offset, length);
+        EXPECT_EQ(oss.str(), sOrig.substr(offset, length));
+    }
+}
@@ -20,3 +20,43 @@ cmp $FILE $FILE".lzw.orig"
 $EXECUTABLE -b $FILE
 $EXECUTABLE -xb $FILE".bwmh"
 cmp $FILE $FILE".bwmh.orig"
+# test bw + mtf + huffman with small blocks
+$EXECUTABLE -b -B 1k $FILE
+$EXECUTABLE -xb $FILE".bwmh"
+cmp $FILE $FILE".bwmh.orig"
+# test multiple threads
+$EXECUTABLE -T 4 -B 1k $FILE
+$EXECUTABLE -x -T 3 $FILE".huffman"
+cmp $FILE $FILE".huffman.orig"
+# test reading with streams instead of memory mapping
+$EXECUTABLE --no-mmap -l $FILE
+$EXECUTABLE --no-mmap -xl $FILE".lzw"
+cmp $FILE $FILE".lzw.orig"
+# test lzw with small codes
+$EXECUTABLE -l -W 9 $FILE
+$EXECUTABLE -xl $FILE".lzw"
+cmp $FILE $FILE".lzw.orig"
+# test detecting the codec from the header
+$EXECUTABLE -l $FILE
+$EXECUTABLE -x $FILE".lzw"
+cmp $FILE $FILE".lzw.orig"
+$EXECUTABLE -b -B 1k $FILE
+$EXECUTABLE -x -T 2 $FILE".bwmh"
+cmp $FILE $FILE".bwmh.orig"
+# test extracting a range, which only expands the blocks containing it
+$EXECUTABLE -B 1k $FILE
+$EXECUTABLE -x --range 1500:2k $FILE".huffman"
+tail -c +1501 $FILE | head -c 2048 | cmp - $FILE".huffman.orig"
+# test printing statistics of the stages
+$EXECUTABLE -b --stats $FILE | grep -q "bw.sort"
+$EXECUTABLE -x --stats $FILE".bwmh" | grep -q "bits per byte"
+cmp $FILE $FILE".bwmh.orig"
+# test extracting without checking the checksums
+$EXECUTABLE -x --no-verify -T 2 $FILE".bwmh"
+cmp $FILE $FILE".bwmh.orig"
+# test that a corrupted file is reported and leaves no partial output
+cp $FILE".bwmh" $FILE".corrupted.bwmh"
+printf '\xff\xff\xff\xff' | dd of=$FILE".corrupted.bwmh" bs=1 seek=100 conv=notrunc
+rm -f $FILE".corrupted.bwmh.orig"
+if $EXECUTABLE -x $FILE".corrupted.bwmh"; then exit 1; fi
+test ! -e $FILE".corrupted.bwmh.orig"
@@ -1,5 +1,6 @@
 #include <gtest/gtest.h>
 #include <sstream>
+#include <random>
 
 #include "CircularSuffix.h"
 
@@ -10,4 +11,55 @@ TEST(cs, basic) { // NOLINT
     EXPECT_EQ(circular_suffix::sort<char>(""), (std::vector<size_t>{}));
     EXPECT_EQ(circular_suffix::sort<uint8_t>(std::basic_string<uint8_t>{0, 70, 30}),
               (std::vector<size_t>{0, 2, 1}));
-}
\ No newline at end of file
+}
+
+TEST(cs, matchesNaive) { // NOLINT
+    // compare the rotations in sorted order since equal rotations of periodic inputs may be ordered differently
+    auto checkFun = [](const std::string& s) {
+        const std::basic_string_view<uint8_t> sv(reinterpret_cast<const uint8_t*>(s.data()), s.size());
+        const auto order = circular_suffix::sort<uint8_t>(sv);
+        const auto orderNaive = circular_suffix::sortNaive<uint8_t>(sv);
+        ASSERT_EQ(order.size(), orderNaive.size());
+        auto rotation = [&sv](const size_t start) {
+            return std::basic_string<uint8_t>(sv.substr(start)) + std::basic_string<uint8_t>(sv.substr(0, start));
+        };
+        for (size_t i=0; i < order.size(); ++i) {
+            EXPECT_EQ(rotation(order[i]), rotation(orderNaive[i]));
+        }
+    };
+
+    checkFun("ABRACADABRA!");
+    checkFun("couscous");
+    checkFun("*************");
+    checkFun("abababababab");
+    checkFun("mississippi");
+    checkFun(std::string("\x00\xff\x00\xff\x80", 5));
+
+    std::mt19937 gen(42); // NOLINT
+    for (const int alphabetSize : {2, 3, 26, 256}) {
+        std::uniform_int_distribution<int> dist(0, alphabetSize-1);
+        for (const size_t len : {2, 17, 100, 1000}) {
+            std::string s(len, '\0');
+            for (auto& c : s) c = static_cast<char>(dist(gen));
+            checkFun(s);
+        }
+    }
+}
+
+TEST(cs, repetitiveLarge) { // NOLINT
+    // would take very long with the naive sort
+    const std::string zeros(1 << 20, '\0');
+    const auto order = circular_suffix::sort<char>(zeros);
+    EXPECT_EQ(order.size(), zeros.size());
+
+    std::string log;
+    while (log.size() < (1 << 20)) log += "INFO request handled in 3ms\n";
+    const auto orderLog = circular_suffix::sort<char>(log);
+    ASSERT_EQ(orderLog.size(), log.size());
+    for (size_t i=1; i < orderLog.size(); i += 4099) {
+        // spot check ordering of neighbouring rotations
+        const std::string lhs = log.substr(orderLog[i-1]) + log.substr(0, orderLog[i-1]);
+        const std::string rhs = log.substr(orderLog[i]) + log.substr(0, orderLog[i]);
+        EXPECT_LE(lhs, rhs);
+    }
+}
@@ -3,11 +3,14 @@
 #include <fstream>
 #include "Huffman.h"
 #include <string>
+#include <random>
+#include <cmath>
+#include <algorithm>
 
 
 TEST(huffman, writeAndReadTrie) { // NOLINT
     const std::string foo = "Lorem ipsum dolor sit amet";
-    const huffman::NodePtr trieRoot1 = huffman::buildTrie(foo);
+    const huffman::Trie trieRoot1 = huffman::buildTrie(foo);
 
     // separate scopes to force flush
     {
@@ -64,4 +67,219 @@ TEST(huffman, easyCompressAndExpand) { // NOLINT
     huffman::expand(iss3, oss3);
     std::string stringDecomp = oss3.str();
     EXPECT_EQ(stringDecomp, stringInput);
-}
\ No newline at end of file
+}
+
+TEST(huffman, longCodes) { // NOLINT
+    // Fibonacci frequencies lead to a maximally unbalanced trie with codes longer than the decoding table
+    std::string sRef;
+    size_t a = 1, b = 1;
+    for (char c = 'a'; c < 'a' + 22; ++c) {
+        sRef += std::string(a, c);
+        const size_t next = a + b;
+        a = b;
+        b = next;
+    }
+    std::shuffle(sRef.begin(), sRef.end(), std::mt19937(42)); // NOLINT
+
+    const huffman::TrieTable table = huffman::internal::trie2table(*huffman::buildTrie(sRef));
+    EXPECT_GT(table['a'].size(), huffman::internal::DecodeTable::primaryBits);
+
+    EXPECT_EQ(huffman::expand(huffman::compress(sRef)), sRef);
+    EXPECT_EQ(huffman::expand(huffman::compress(sRef + "x")), sRef + "x"); // odd number of symbols
+}
+
+TEST(huffman, singleCharacter) { // NOLINT
+    const std::string sRef(1000, 'z');
+    EXPECT_EQ(huffman::expand(huffman::compress(sRef)), sRef);
+    EXPECT_EQ(huffman::expand(huffman::compress("z")), "z");
+}
+
+TEST(huffman, truncatedInput) { // NOLINT
+    const std::string sRef = "Lorem ipsum dolor sit amet";
+    const std::string sComp = huffman::compress(sRef);
+    EXPECT_ANY_THROW(huffman::expand(sComp.substr(0, sComp.size() - 2)));
+}
+
+TEST(huffman, canonicalCodes) { // NOLINT
+    huffman::CodeLengths lengths{};
+    lengths['a'] = 1;
+    lengths['b'] = 3;
+    lengths['c'] = 2;
+    lengths['d'] = 3;
+    const huffman::TrieTable table = huffman::internal::canonicalCodes(lengths);
+    auto toString = [](const ShortBitSet& bs) {
+        std::string s;
+        for (size_t i = 0; i < bs.size(); ++i) s += bs.at(i) ? '1' : '0';
+        return s;
+    };
+    EXPECT_EQ(toString(table['a']), "0");
+    EXPECT_EQ(toString(table['c']), "10");
+    EXPECT_EQ(toString(table['b']), "110");
+    EXPECT_EQ(toString(table['d']), "111");
+    EXPECT_TRUE(table['e'].empty());
+
+    lengths['e'] = 1; // more codes than possible
+    EXPECT_ANY_THROW(huffman::internal::canonicalCodes(lengths));
+}
+
+TEST(huffman, writeAndReadCodeLengths) { // NOLINT
+    const std::string foo = "Lorem ipsum dolor sit amet";
+    const huffman::CodeLengths lengths = huffman::internal::codeLengths(*huffman::buildTrie(foo));
+
+    std::ostringstream oss;
+    {
+        BitStreamOut bso(oss);
+        huffman::internal::writeCodeLengths(bso, lengths);
+    }
+    std::istringstream iss(oss.str());
+    BitStreamIn bsi(iss);
+    EXPECT_EQ(huffman::internal::readCodeLengths(bsi), lengths);
+
+    // header is smaller than the trie
+    std::ostringstream ossTrie;
+    {
+        BitStreamOut bso(ossTrie);
+        huffman::internal::writeTrie(bso, *huffman::buildTrie(foo));
+    }
+    EXPECT_LT(oss.str().size(), ossTrie.str().size());
+}
+
+TEST(huffman, formats) { // NOLINT
+    const std::string sRef = "Lorem ipsum.\r\nDolor sit amet.";
+    for (const auto format : {huffman::Format::Trie, huffman::Format::Canonical}) {
+        EXPECT_EQ(huffman::expand(huffman::compress(sRef, format), format), sRef);
+        EXPECT_EQ(huffman::expand(huffman::compress("zz", format), format), "zz");
+    }
+    EXPECT_LT(huffman::compress(sRef, huffman::Format::Canonical).size(),
+              huffman::compress(sRef, huffman::Format::Trie).size());
+
+    // the format is not recorded, so the default stays the one of data written before canonical codes
+    EXPECT_EQ(huffman::compress(sRef), huffman::compress(sRef, huffman::Format::Trie));
+
+    // empty input can only be compressed with canonical codes
+    EXPECT_EQ(huffman::expand(huffman::compress("", huffman::Format::Canonical), huffman::Format::Canonical), "");
+    EXPECT_ANY_THROW(huffman::compress("", huffman::Format::Trie));
+}
+
+TEST(huffman, lengthLimited) { // NOLINT
+    // Fibonacci frequencies for 40 characters would need codes of 39 bits
+    std::array<int, huffman::R> freq{};
+    int a = 1, b = 1;
+    for (size_t c = 0; c < 40; ++c) {
+        freq[c] = a;
+        const int next = a + b;
+        a = b;
+        b = next;
+    }
+
+    for (const size_t maxLength : {6, 12, 15, 32}) {
+        const huffman::CodeLengths lengths = huffman::internal::packageMerge(freq, maxLength);
+        double kraftSum = 0;
+        for (const auto len : lengths) {
+            EXPECT_LE(len, maxLength);
+            if (len > 0) kraftSum += std::pow(2.0, -len);
+        }
+        EXPECT_DOUBLE_EQ(kraftSum, 1.0); // complete code
+
+        const auto trieRoot = huffman::internal::buildTrie(freq, maxLength);
+        EXPECT_LE(huffman::internal::depth(*trieRoot), maxLength);
+        EXPECT_EQ(huffman::internal::codeLengths(*trieRoot), lengths);
+        EXPECT_NO_THROW(huffman::internal::trie2table(*trieRoot)); // would exceed ShortBitSet without limit
+    }
+    EXPECT_ANY_THROW(huffman::internal::packageMerge(freq, 5)); // 40 characters need at least 6 bits
+
+    // optimal codes that are short enough are not changed
+    const std::string foo = "Lorem ipsum dolor sit amet";
+    std::array<int, huffman::R> freqFoo{};
+    for (const char c : foo) ++freqFoo[static_cast<uint8_t>(c)];
+    const auto lengthsFoo = huffman::internal::codeLengths(*huffman::buildTrie(foo));
+    size_t costHuffman = 0, costPackageMerge = 0;
+    const auto lengthsPackageMerge = huffman::internal::packageMerge(freqFoo, 15);
+    for (size_t c = 0; c < huffman::R; ++c) {
+        costHuffman += freqFoo[c] * lengthsFoo[c];
+        costPackageMerge += freqFoo[c] * lengthsPackageMerge[c];
+    }
+    EXPECT_EQ(costHuffman, costPackageMerge);
+}
+
+TEST(huffman, singlePass) { // NOLINT
+    std::string sRef;
+    for (int i = 0; i < 100000; ++i) sRef += static_cast<char>((i * i) % 251);
+
+    for (const auto format : {huffman::Format::Trie, huffman::Format::Canonical}) {
+        for (const std::string& input : {sRef, std::string("a"), std::string("abc")}) {
+            // same output as reading two streams
+            std::istringstream iss1(input, std::ios::binary);
+            std::istringstream iss2(input, std::ios::binary);
+            std::ostringstream ossStreams(std::ios::binary);
+            huffman::compress(iss1, iss2, ossStreams, format);
+
+            std::ostringstream ossView(std::ios::binary);
+            huffman::compress(std::string_view(input), ossView, format);
+            EXPECT_EQ(ossView.str(), ossStreams.str());
+            EXPECT_EQ(huffman::expand(ossView.str(), format), input);
+        }
+    }
+}
+
+TEST(huffman, symbols) { // NOLINT
+    // alphabet with more symbols than characters of a byte, the last group of 16 symbols is partial
+    constexpr size_t N = 300;
+    std::vector<uint16_t> sRef;
+    for (size_t i = 0; i < 100000; ++i) sRef.push_back(static_cast<uint16_t>((i * i + i / 3) % N));
+    sRef.push_back(N - 1);
+
+    for (const std::vector<uint16_t>& input : {sRef, std::vector<uint16_t>{}, std::vector<uint16_t>{299},
+                                               std::vector<uint16_t>(1000, 256), std::vector<uint16_t>{0, 299, 0}}) {
+        EXPECT_EQ(huffman::expandSymbols<N>(huffman::compressSymbols<N>(input)), input);
+    }
+    // a single symbol is encoded with 0 bits
+    EXPECT_LT(huffman::compressSymbols<N>(std::vector<uint16_t>(1000, 256)).size(), 16);
+    EXPECT_ANY_THROW(huffman::compressSymbols<N>(std::vector<uint16_t>{N}));
+
+    // code lengths of large alphabets are read back in the same way
+    std::array<uint8_t, N> lengths{};
+    lengths[5] = 1;
+    lengths[257] = 2;
+    lengths[N - 1] = 2;
+    std::ostringstream oss(std::ios::binary);
+    {
+        BitStreamOut bso(oss);
+        huffman::internal::writeCodeLengths(bso, lengths);
+    }
+    std::istringstream iss(oss.str(), std::ios::binary);
+    BitStreamIn bsi(iss);
+    EXPECT_EQ(huffman::internal::readCodeLengths<N>(bsi), lengths);
+}
+
+TEST(huffman, multiTable) { // NOLINT
+    // non-stationary input: parts with different distributions of the symbols
+    constexpr size_t N = 257;
+    std::vector<uint16_t> sRef;
+    std::mt19937 gen(42); // NOLINT
+    for (size_t part = 0; part < 40; ++part) {
+        std::geometric_distribution<int> dist(part % 2 ? 0.5 : 0.05);
+        const size_t offset = (part % 3) * 50;
+        for (size_t i = 0; i < 1000 + part * 7; ++i) {
+            sRef.push_back(static_cast<uint16_t>((offset + static_cast<size_t>(dist(gen))) % N));
+        }
+    }
+
+    for (const std::vector<uint16_t>& input : {sRef, std::vector<uint16_t>{}, std::vector<uint16_t>{256},
+                                               std::vector<uint16_t>(1000, 7), std::vector<uint16_t>{0, 256, 0},
+                                               std::vector<uint16_t>(sRef.begin(), sRef.begin() + 51)}) {
+        for (size_t maxTables = 1; maxTables <= huffman::maxNumTables; ++maxTables) {
+            EXPECT_EQ(huffman::expandSymbolsMultiTable<N>(huffman::compressSymbolsMultiTable<N>(input, maxTables)),
+                      input);
+        }
+    }
+    EXPECT_LT(huffman::compressSymbolsMultiTable<N>(sRef).size(), huffman::compressSymbols<N>(sRef).size() * 9 / 10);
+    EXPECT_LT(huffman::compressSymbolsMultiTable<N>(sRef).size(),
+              huffman::compressSymbolsMultiTable<N>(sRef, 1).size());
+
+    EXPECT_ANY_THROW(huffman::compressSymbolsMultiTable<N>(sRef, 0));
+    EXPECT_ANY_THROW(huffman::compressSymbolsMultiTable<N>(sRef, huffman::maxNumTables + 1));
+    EXPECT_ANY_THROW(huffman::compressSymbolsMultiTable<N>(std::vector<uint16_t>{N}));
+    const std::string truncated = huffman::compressSymbolsMultiTable<N>(sRef).substr(0, 100);
+    EXPECT_ANY_THROW(huffman::expandSymbolsMultiTable<N>(truncated));
+}
@@ -40,3 +40,92 @@ TEST(lzw, basic) { // NOLINT
 //
 //    std::cout << "Decompressed: " << sDecompressed << "\n";
 }
+
+TEST(lzw, formats) { // NOLINT
+    // text followed by differently distributed data, so the dictionary gets full and is reset
+    std::string sRef;
+    for (int i = 0; i < 20000; ++i) sRef += "ABRACADABRA! " + std::to_string(i) + "\n";
+    for (int i = 0; i < 200000; ++i) sRef += static_cast<char>((i * i + i / 7) % 251);
+    for (int i = 0; i < 20000; ++i) sRef += "foo bar " + std::to_string(i % 100) + "\n";
+
+    for (const std::string& input : {std::string(), std::string("a"), std::string("ABABABA"), sRef}) {
+        EXPECT_EQ(lzw::expand(lzw::compress(input, lzw::Format::Fixed)), input);
+        for (const size_t maxWidth : {size_t{9}, size_t{12}, size_t{16}, lzw::maxMaxWidth}) {
+            const std::string compressed = lzw::compress(input, lzw::Format::Variable, maxWidth);
+            EXPECT_EQ(static_cast<uint8_t>(compressed[0]), lzw::variableVersion);
+            EXPECT_EQ(lzw::expand(compressed), input);
+        }
+    }
+    // first byte of the fixed format is at most 0x10
+    EXPECT_LE(static_cast<uint8_t>(lzw::compress(std::string(1, '\xff'), lzw::Format::Fixed)[0]), 0x10);
+    EXPECT_LT(lzw::compress(sRef).size(), lzw::compress(sRef, lzw::Format::Fixed).size());
+
+    EXPECT_ANY_THROW(lzw::compress(sRef, lzw::Format::Variable, 8));
+    EXPECT_ANY_THROW(lzw::compress(sRef, lzw::Format::Variable, lzw::maxMaxWidth + 1));
+    EXPECT_ANY_THROW(lzw::expand(""));
+    EXPECT_ANY_THROW(lzw::expand(std::string{static_cast<char>(lzw::variableVersion), 30, 0, 0}));
+}
+
+TEST(lzw, clear) { // NOLINT
+    // with the smallest width, the dictionary is full after a few hundred codes; when the data changes, it is reset
+    // and the second part is compressed about as well as on its own instead of with the entries for the first part
+    std::string part1, part2;
+    for (int i = 0; i < 100000; ++i) part1 += static_cast<char>('a' + i % 3);
+    for (int i = 0; i < 100000; ++i) part2 += static_cast<char>('x' + (i / 5) % 4);
+    const std::string compressed = lzw::compress(part1 + part2, lzw::Format::Variable, 9);
+    EXPECT_EQ(lzw::expand(compressed), part1 + part2);
+    const size_t separateSize = lzw::compress(part1, lzw::Format::Variable, 9).size()
+                                + lzw::compress(part2, lzw::Format::Variable, 9).size();
+    EXPECT_LT(compressed.size(), 2 * separateSize); // about ten times larger without reset
+}
+
+TEST(lzw, dictionaries) { // NOLINT
+    // the dictionaries are sized for the input, so short input does not allocate room for all codes
+    std::string sRef;
+    for (int i = 0; i < 20000; ++i) sRef += "ABRACADABRA! " + std::to_string(i * 31 % 1000) + "\n";
+    for (int i = 0; i < 100000; ++i) sRef += static_cast<char>((i * i + i / 7) % 251);
+
+    for (const std::string& input : {std::string(), std::string("a"), std::string("ABABABA"), sRef}) {
+        EXPECT_EQ(lzw::compress<lzw::HashDictionary>(input, lzw::Format::Fixed),
+                  lzw::compress<lzw::TrieDictionary>(input, lzw::Format::Fixed));
+        for (const size_t maxWidth : {size_t{9}, size_t{16}, lzw::maxMaxWidth}) {
+            EXPECT_EQ(lzw::compress<lzw::HashDictionary>(input, lzw::Format::Variable, maxWidth),
+                      lzw::compress<lzw::TrieDictionary>(input, lzw::Format::Variable, maxWidth));
+        }
+    }
+}
+
+TEST(lzw, expandInvalid) { // NOLINT
+    // fixed format: the first code has to be a single character or EOF
+    EXPECT_ANY_THROW(lzw::expand(std::string{0x10, 0x10, 0x10}));
+    // variable format: code 0x1FF is not assigned yet
+    const std::string invalid{static_cast<char>(lzw::variableVersion), 9, static_cast<char>(0xFF), static_cast<char>(0x80), 0, 0};
+    EXPECT_ANY_THROW(lzw::expand(invalid));
+
+    // long runs create long entries
+    const std::string sRef(2000000, 'a');
+    EXPECT_EQ(lzw::expand(lzw::compress(sRef, lzw::Format::Variable, lzw::maxMaxWidth)), sRef);
+}
+
+TEST(lzw, streaming) { // NOLINT
+    // matches span the boundaries of the chunks in which streams are read
+    std::string sRef;
+    for (int i = 0; i < 30000; ++i) sRef += "ABRACADABRA! " + std::to_string(i * 31 % 1000) + "\n";
+    sRef += std::string(3 * lzw::internal::chunkSize, 'a');
+    for (int i = 0; i < 100000; ++i) sRef += static_cast<char>((i * i + i / 7) % 251);
+
+    for (const std::string& input : {sRef, sRef.substr(0, lzw::internal::chunkSize), std::string("a")}) {
+        for (const auto format : {lzw::Format::Fixed, lzw::Format::Variable}) {
+            std::istringstream iss(input, std::ios::binary);
+            std::ostringstream oss(std::ios::binary);
+            lzw::compress(iss, oss, format);
+            EXPECT_EQ(oss.str(), lzw::compress(input, format)); // string is compressed at once
+            EXPECT_EQ(lzw::expand(oss.str()), input);
+
+            std::istringstream issTrie(input, std::ios::binary);
+            std::ostringstream ossTrie(std::ios::binary);
+            lzw::compress<lzw::TrieDictionary>(issTrie, ossTrie, format);
+            EXPECT_EQ(ossTrie.str(), oss.str());
+        }
+    }
+}
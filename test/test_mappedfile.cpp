@@ -0,0 +1,49 @@
+#include <gtest/gtest.h>
+#include <fstream>
+#include <cstdio>
+#include "MappedFile.h"
+#include "MemoryStreamBuf.h"
+
+TEST(mappedFile, view) { // NOLINT
+    const std::string filename = "mappedFile.dat";
+    std::string sRef;
+    for (int i = 0; i < 100000; ++i) sRef += static_cast<char>(i % 256);
+    {
+        std::ofstream ofs(filename, std::ios::binary);
+        ofs << sRef;
+    }
+    {
+        const MappedFile mapped(filename);
+        EXPECT_EQ(mapped.view(), sRef);
+    }
+
+    std::ofstream(filename, std::ios::binary | std::ios::trunc).close();
+    {
+        const MappedFile mapped(filename);
+        EXPECT_TRUE(mapped.view().empty());
+    }
+    std::remove(filename.c_str());
+
+    EXPECT_ANY_THROW(MappedFile("does/not/exist.dat"));
+}
+
+TEST(mappedFile, memoryStreamBuf) { // NOLINT
+    const std::string sRef = "Lorem ipsum dolor sit amet";
+    MemoryStreamBuf buf(sRef);
+    std::istream is(&buf);
+
+    std::string word;
+    is >> word;
+    EXPECT_EQ(word, "Lorem");
+    is.seekg(0);
+    const std::string all(std::istreambuf_iterator<char>(is), {});
+    EXPECT_EQ(all, sRef);
+
+    is.clear();
+    is.seekg(-4, std::ios::end);
+    is >> word;
+    EXPECT_EQ(word, "amet");
+    is.clear();
+    is.seekg(100);
+    EXPECT_TRUE(is.fail());
+}
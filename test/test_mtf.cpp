@@ -18,4 +18,55 @@ TEST(mtf, basic) { // NOLINT
     mtf::decode(iss, oss);
     std::string sDec = oss.str();
     EXPECT_EQ(sOrig, sDec);
-}
\ No newline at end of file
+}
+
+TEST(mtf, inPlace) { // NOLINT
+    std::string sOrig;
+    for (int i = 0; i < 200000; ++i) sOrig += static_cast<char>((i * i) % 256); // larger than the stream chunks
+    std::istringstream iss(sOrig);
+    std::ostringstream oss;
+    mtf::encode(iss, oss);
+
+    std::string buf = sOrig;
+    mtf::encode(buf);
+    EXPECT_EQ(buf, oss.str());
+    mtf::decode(buf);
+    EXPECT_EQ(buf, sOrig);
+}
+
+TEST(mtf, kernels) { // NOLINT
+    // all ranks occur, including ranks that do not fill a whole vector and runs of rank 0
+    std::string sOrig;
+    for (int i = 0; i < 100000; ++i) sOrig += static_cast<char>((i * i * 7 + i / 3) % (i % 5 == 0 ? 256 : 37));
+    sOrig += std::string(1000, 'x') + std::string(1000, 'y');
+
+    std::string sScalar = sOrig;
+    {
+        mtf::internal::State state;
+        mtf::internal::encode(state, sScalar.data(), sScalar.size());
+    }
+
+    std::vector<mtf::internal::Kernel> encodeKernels = {mtf::internal::encodeKernel()};
+    std::vector<mtf::internal::Kernel> decodeKernels = {mtf::internal::decodeKernel()};
+#ifdef MTF_X86_KERNELS
+    if (mtf::internal::supportsSSE2()) {
+        encodeKernels.push_back(mtf::internal::encodeSSE2);
+        decodeKernels.push_back(mtf::internal::decodeSSE2);
+    }
+    if (mtf::internal::supportsAVX2()) {
+        encodeKernels.push_back(mtf::internal::encodeAVX2);
+        decodeKernels.push_back(mtf::internal::decodeAVX2);
+    }
+#endif
+    for (size_t k = 0; k < encodeKernels.size(); ++k) {
+        std::string buf = sOrig;
+        mtf::internal::State encodeState;
+        encodeKernels[k](encodeState, buf.data(), 1000); // state is kept between chunks
+        encodeKernels[k](encodeState, buf.data() + 1000, buf.size() - 1000);
+        EXPECT_EQ(buf, sScalar);
+
+        mtf::internal::State decodeState;
+        decodeKernels[k](decodeState, buf.data(), buf.size());
+        EXPECT_EQ(buf, sOrig);
+    }
+}
@@ -0,0 +1,67 @@
+#include <gtest/gtest.h>
+#include <string>
+#include <vector>
+
+#include "NodePool.h"
+#include "external/TernarySearchTrie.h"
+
+
+TEST(nodePool, createAndClear) { // NOLINT
+    struct Node {
+        int value;
+        Node* next;
+    };
+    NodePool<Node> pool(4);
+    std::vector<Node*> nodes;
+    Node* prev = nullptr;
+    for (int i = 0; i < 100; ++i) {
+        prev = pool.create(Node{i, prev});
+        nodes.push_back(prev);
+    }
+    EXPECT_EQ(pool.size(), 100);
+    // nodes do not move when the pool grows or is moved
+    NodePool<Node> moved(std::move(pool));
+    for (size_t i = 0; i < nodes.size(); ++i) {
+        EXPECT_EQ(nodes[i]->value, static_cast<int>(i));
+        EXPECT_EQ(nodes[i]->next, i > 0 ? nodes[i - 1] : nullptr);
+    }
+
+    // the memory is reused after clearing
+    moved.clear();
+    EXPECT_EQ(moved.size(), 0);
+    EXPECT_EQ(moved.create(Node{0, nullptr}), nodes[0]);
+    for (int i = 1; i < 100; ++i) moved.create(Node{i, nullptr});
+    EXPECT_EQ(moved.create(Node{100, nullptr}), nodes[99] + 1);
+}
+
+TEST(nodePool, destructors) { // NOLINT
+    int numDestroyed = 0;
+    struct Counter {
+        int* numDestroyed;
+        ~Counter() { ++*numDestroyed; }
+    };
+    {
+        NodePool<Counter> pool(3);
+        for (int i = 0; i < 10; ++i) pool.create(Counter{&numDestroyed});
+        numDestroyed = 0; // temporaries
+        pool.clear();
+        EXPECT_EQ(numDestroyed, 10);
+        for (int i = 0; i < 5; ++i) pool.create(Counter{&numDestroyed});
+        numDestroyed = 0;
+    }
+    EXPECT_EQ(numDestroyed, 5);
+}
+
+TEST(nodePool, ternarySearchTrie) { // NOLINT
+    TernarySearchTrie<int> st(2);
+    for (int round = 0; round < 2; ++round) {
+        st.put("she", 0);
+        st.put("sells", 1);
+        st.put("shells", 2);
+        EXPECT_EQ(st.get("sells"), 1);
+        EXPECT_FALSE(st.contains("shell"));
+        EXPECT_EQ(st.longestPrefixOf("shellsort"), "shells");
+        st.clear();
+        EXPECT_FALSE(st.contains("she"));
+    }
+}
@@ -0,0 +1,76 @@
+#define COMPRESSION_STATS // instrument the codecs in this file only
+#include <gtest/gtest.h>
+#include <sstream>
+#include <string>
+#include "BWMH.h"
+#include "LZW.h"
+#include "Stats.h"
+
+TEST(stats, stages) { // NOLINT
+    std::string sRef;
+    for (int i = 0; i < 2000; ++i) sRef += "ABRACADABRA! " + std::to_string(i % 100) + "\n";
+
+    stats::reset();
+    stats::enable();
+    const std::string compressed = bwmh::compressBlock(sRef);
+    stats::enable(false);
+    const auto stages = stats::stages();
+    for (const char* name : {"bw", "bw.sort", "mtf", "zero_run", "huffman", "huffman.histogram", "huffman.codes",
+                             "huffman.encode"}) {
+        ASSERT_EQ(stages.count(name), 1u) << name;
+        EXPECT_EQ(stages.at(name).calls, 1u) << name;
+    }
+    EXPECT_EQ(stages.at("bw").bytesIn, sRef.size());
+    EXPECT_EQ(stages.at("bw").bytesOut, sRef.size() + 4);
+    EXPECT_EQ(stages.at("mtf").bytesIn, sRef.size() + 4);
+    EXPECT_EQ(stages.at("zero_run").bytesOut, stages.at("huffman").bytesIn);
+    // symbols count as 2 bytes
+    std::string transformed = bw::encode(sRef);
+    mtf::encode(transformed);
+    EXPECT_EQ(stages.at("zero_run").bytesOut, 2 * zero_run::encode(transformed).size());
+    EXPECT_EQ(stages.at("huffman").bytesOut, compressed.size());
+    // parts take no longer than their stage
+    EXPECT_LE(stages.at("bw.sort").seconds, stages.at("bw").seconds);
+    EXPECT_GT(stages.at("bw").seconds, 0);
+
+    // nothing is recorded while disabled
+    stats::reset();
+    EXPECT_EQ(lzw::expand(lzw::compress(sRef)), sRef);
+    EXPECT_TRUE(stats::stages().empty());
+}
+
+TEST(stats, entropy) { // NOLINT
+    stats::reset();
+    stats::enable();
+    stats::count("aabb");
+    EXPECT_DOUBLE_EQ(stats::entropy(), 1.0);
+    stats::count(std::string(4, 'c'));
+    EXPECT_DOUBLE_EQ(stats::entropy(), 1.5);
+
+    stats::reset();
+    std::string allBytes;
+    for (int c = 0; c < 256; ++c) allBytes += static_cast<char>(c);
+    stats::count(allBytes);
+    EXPECT_DOUBLE_EQ(stats::entropy(), 8.0);
+
+    // the uncompressed data of block streams is counted on both sides
+    stats::reset();
+    std::istringstream iss(allBytes + allBytes, std::ios::binary);
+    std::ostringstream oss(std::ios::binary);
+    block::compress(iss, oss, 100, bwmh::compressBlock, 2);
+    EXPECT_EQ(stats::numCounted(), 2 * allBytes.size());
+    EXPECT_EQ(stats::stages().at("crc32c").calls, 6u);
+
+    stats::reset();
+    std::istringstream issComp(oss.str(), std::ios::binary);
+    std::ostringstream ossExp(std::ios::binary);
+    bwmh::expand(issComp, ossExp);
+    EXPECT_EQ(ossExp.str(), allBytes + allBytes);
+    EXPECT_EQ(stats::numCounted(), 2 * allBytes.size());
+    EXPECT_DOUBLE_EQ(stats::entropy(), 8.0);
+
+    std::ostringstream report;
+    stats::report(report);
+    EXPECT_NE(report.str().find("8.000 bits per byte"), std::string::npos);
+    stats::enable(false);
+}
@@ -0,0 +1,41 @@
+#include <gtest/gtest.h>
+#include <string>
+#include <vector>
+
+#include "ZeroRun.h"
+
+
+TEST(zeroRun, encodeAndDecode) { // NOLINT
+    using zero_run::RUNA;
+    using zero_run::RUNB;
+
+    // run lengths in bijective base 2, least significant digit first
+    EXPECT_EQ(zero_run::encode(std::string(1, '\0')), (std::vector<uint16_t>{RUNA}));
+    EXPECT_EQ(zero_run::encode(std::string(2, '\0')), (std::vector<uint16_t>{RUNB}));
+    EXPECT_EQ(zero_run::encode(std::string(3, '\0')), (std::vector<uint16_t>{RUNA, RUNA}));
+    EXPECT_EQ(zero_run::encode(std::string(4, '\0')), (std::vector<uint16_t>{RUNB, RUNA}));
+    EXPECT_EQ(zero_run::encode(std::string(6, '\0')), (std::vector<uint16_t>{RUNB, RUNB}));
+    // other bytes are shifted by one
+    EXPECT_EQ(zero_run::encode(std::string("\x01\0\xff", 3)), (std::vector<uint16_t>{2, RUNA, 256}));
+    EXPECT_TRUE(zero_run::encode("").empty());
+
+    std::string sRef;
+    for (size_t i = 0; i < 2000; ++i) {
+        sRef += std::string(i % 37, '\0');
+        sRef += static_cast<char>(1 + i % 255);
+    }
+    sRef += std::string(100000, '\0');
+    const std::vector<uint16_t> symbols = zero_run::encode(sRef);
+    EXPECT_LT(symbols.size(), sRef.size() / 5);
+    EXPECT_EQ(zero_run::decode(symbols, sRef.size()), sRef);
+    for (size_t n = 0; n < 70; ++n) {
+        EXPECT_EQ(zero_run::decode(zero_run::encode(std::string(n, '\0')), n), std::string(n, '\0'));
+    }
+
+    EXPECT_THROW(zero_run::decode({zero_run::numSymbols}, 10), std::runtime_error);
+    // runs and other bytes beyond the maximum size are rejected
+    EXPECT_THROW(zero_run::decode(symbols, sRef.size() - 1), std::runtime_error);
+    EXPECT_THROW(zero_run::decode({RUNA, RUNA, 2}, 3), std::runtime_error);
+    EXPECT_THROW(zero_run::decode(std::vector<uint16_t>(36, RUNA), size_t{1} << 30), std::runtime_error);
+    EXPECT_THROW(zero_run::decode(std::vector<uint16_t>(100, RUNB), SIZE_MAX), std::runtime_error);
+}